@@ -5,7 +5,26 @@
  #include <stdio.h>
  #include <stdlib.h>
  #include <string.h>
+ #include <getopt.h>
+ #include <unistd.h>
+ #include <sys/wait.h>
  #include "cachesim.h"
+ #include "setindex.h"
+ #include "waypred.h"
+ #include "checkpoint.h"
+ #include "sampling.h"
+ #include "shards.h"
+ #include "policy.h"
+ #include "fullassoc.h"
+ #include "misstrace.h"
+ #include "tagstore.h"
+ #include "pagemap.h"
+ #include "partition.h"
+ #include "dram.h"
+ #include "timeseries.h"
+ #include "nuca.h"
+ #include "deadblock.h"
+ #include "tlb.h"
  
  // Statistics you will need to keep track. DO NOT CHANGE THESE.
  counter_t accesses = 0;     // Total number of cache accesses
@@ -32,66 +51,787 @@
  
  //  Here are some global variables you may find useful to get you started.
  //      Feel free to add/change anyting here.
- cache_set_t* cache;     // Data structure for the cache
+ cache_state_t* state;   // Data structure for the cache, see cache_state_t
+ cache_block_t* lines;   // All cache blocks, one set after another
+ tag_store_t tags;       // Tags of all cache blocks, packed, see tagstore.h
+ counter_t* stamps;      // Time of last use of every block, skewed caches only
+ int* lru_ranks;         // LRU stack storage, <ways> ranks per set
+ int* mru_ways;          // MRU way of each set
+ unsigned long long* set_ready;  // Bitmap of the sets set up so far
+ unsigned char* block_streams;  // Stream that filled each block, shared caches only
  int block_size;         // Block size
- int cache_size;         // Cache size
+ long long cache_size;   // Cache size
  int ways;               // Ways
  int num_sets;           // Number of sets
  int num_offset_bits;    // Number of offset bits
  int num_index_bits;     // Number of index bits. 
- 
+ int addr_bits = 32;     // Address bits simulated, the rest of each address is ignored
+ addr_t addr_mask;       // Mask of those bits
+ int tag_bits;           // Bits in the largest tag the geometry can produce
+
+ // Set indexing. See setindex.h for the available functions.
+ int index_fn = INDEX_BITSLICE;  // Index function used to pick a set
+ int index_prime = 1;            // Modulus for INDEX_PRIME
+ fastmod_t set_mod;              // Reciprocal of the modulus for INDEX_PRIME and INDEX_MODULO
+ int zcache_levels = 2;          // Depth of the zcache replacement walk for INDEX_SKEW
+ counter_t relocations = 0;      // Blocks moved to another way by zcache replacement
+ counter_t clock_stamp = 0;      // Timestamp source for LRU across skewed ways
+ int sampling_active = 0;        // 1 if the stats are extrapolated from sampled intervals
+
+ // Redundant-access filter. The block touched by the last access is always resident
+ // and MRU afterwards, so another access to it is a hit that only has to update the
+ // dirty bit (and the timestamp of a skewed cache). Runs of same-block accesses skip
+ // the lookup and give exactly the same statistics.
+ #define NO_BLOCK (~0ULL)
+ int filter_enabled = 1;         // 0 to send every access through the full lookup
+ int filter_stats = 0;           // 1 to report how many accesses the filter served
+ addr_t last_block = NO_BLOCK;   // Block touched by the last access
+ cache_block_t* last_line;       // ...where it is in the cache
+ int last_way;                   // ...and its way
+ counter_t filtered = 0;         // Accesses served by the filter
+
+ int mrc_enabled = 0;            // 1 to build a SHARDS miss ratio curve of the trace
+
+ // Hashed lookup for fully and highly associative caches, see fullassoc.h
+ #define DEFAULT_HASH_WAYS 32
+ int hash_ways = DEFAULT_HASH_WAYS;  // Associativity from which the hashed lookup is used, 0 for never
+ int hashed = 0;                     // 1 if this cache uses it
+ fa_t fa;                            // View of its structures in the arena
+
+ int state_stats = 0;            // 1 to report the tag width and the sets touched
+ int misstrace_enabled = 0;      // 1 to write the miss and writeback stream, see misstrace.h
+ int dram_enabled = 0;           // 1 to time the miss and writeback stream in DRAM, see dram.h
+ int timeseries_enabled = 0;     // 1 to write per-interval statistics, see timeseries.h
+ counter_t trace_index = 0;      // Index of the current access in the original trace
+
+ #define ZCACHE_MAX_LEVELS 4
+ #define ZCACHE_MAX_CANDIDATES 4096
+
+ // Sections of the state arena start on cache line boundaries
+ #define STATE_ALIGN(x) (((x) + 63) & ~(size_t) 63)
+
+ // Index of block <way> of set <set> in the lines, tags and stamps arrays
+ #define LINE_INDEX(set, way) ((size_t) (set) * ways + (way))
+
  /**
-  * Function to intialize your cache simulator with the given cache parameters. 
-  * Note that we will only input valid parameters and all the inputs will always 
-  * be a power of 2.
-  * 
+  * Function to compute the cache geometry and index function parameters.
+  *
   * @param _block_size is the block size in bytes
   * @param _cache_size is the cache size in bytes
   * @param _ways is the associativity
   */
- void cachesim_init(int _block_size, int _cache_size, int _ways) {
+ static void set_geometry(int _block_size, long long _cache_size, int _ways) {
      // Set cache parameters to global variables
      block_size = _block_size;
      cache_size = _cache_size;
      ways = _ways;
- 
-     ////////////////////////////////////////////////////////////////////
-     //  TODO: Write the rest of the code needed to initialize your cache
-     //  simulator. Some of the things you may want to do are:
-     //      - Calculate any values you need such as number of index bits.
-     //      - Allocate any data structures you need.   
-     ////////////////////////////////////////////////////////////////////
-     num_sets = (cache_size) / (block_size * ways); // Computes the number of sets that is available for the cache
+
+     num_sets = (int) ((cache_size) / ((long long) block_size * ways)); // Computes the number of sets that is available for the cache
      num_index_bits = simple_log_2(num_sets); //Computes the number of index bits by taking the log base 2 of the number of sets
      num_offset_bits = simple_log_2(block_size); // Computes the amount of offset bits
+
+     // A single set has nothing to hash, so every index function is a bit slice, and
+     // a set count that is not a power of 2 has no bits to slice
+     if (num_sets == 1) {
+         index_fn = INDEX_BITSLICE;
+     } else if (index_fn == INDEX_BITSLICE && (num_sets & (num_sets - 1)) != 0) {
+         index_fn = INDEX_MODULO;
+     }
+     index_prime = index_largest_prime(num_sets);
+     set_mod = fastmod_init(index_fn == INDEX_PRIME ? index_prime : num_sets);
+
+     // One set, or enough ways that scanning them dominates, gets the hashed lookup
+     hashed = hash_ways > 0 && index_fn != INDEX_SKEW && (num_sets == 1 || ways >= hash_ways);
+
+     // Tags hold the block address bits the set does not: none for a skewed cache,
+     // the quotient for the modulo functions and the upper bits otherwise
+     addr_mask = (addr_bits == 64) ? ~0ULL : (1ULL << addr_bits) - 1;
+     int block_bits = addr_bits - num_offset_bits;
+     if (index_fn == INDEX_SKEW) {
+         tag_bits = block_bits;
+     } else if (index_fn == INDEX_PRIME || index_fn == INDEX_MODULO) {
+         tag_bits = block_bits - simple_log_2((int) set_mod.d);
+     } else {
+         tag_bits = block_bits - num_index_bits;
+     }
+ }
+
+ /**
+  * Function to point the global block and replacement state arrays at the sections
+  * of the arena <s>.
+  */
+ static void state_attach(cache_state_t* s) {
+     state = s;
+     lines = (cache_block_t*) ((char*) s + s->lines_offset);
+     tags.base = (unsigned char*) s + s->tags_offset;
+     tags.bytes = s->tag_bytes;
+     stamps = (counter_t*) ((char*) s + s->stamps_offset);
+     set_ready = (unsigned long long*) ((char*) s + s->ready_offset);
+     lru_ranks = (int*) ((char*) s + s->ranks_offset);
+     mru_ways = (int*) ((char*) s + s->mru_offset);
+     ship_shct = (unsigned char*) s + s->shct_offset;
+     fa.slots = (unsigned*) ((char*) s + s->slots_offset);
+     fa.mask = (unsigned) ((1ULL << s->hash_bits) - 1);
+     fa.bits = s->hash_bits;
+     fa.links = (fa_link_t*) ((char*) s + s->links_offset);
+     fa.lists = (fa_list_t*) ((char*) s + s->lists_offset);
+     block_streams = (unsigned char*) s + s->streams_offset;
+     waypred_pc_table = (int*) ((char*) s + s->pc_table_offset);
+     fa.tags = tags;
+     fa.ways = s->ways;
+ }
+
+ /**
+  * Function to set up set <idx> the first time it is touched. Until then it is all
+  * zeros, which already is a set of invalid blocks with way 0 as the MRU way, so only
+  * the replacement order has to be filled in. Sets that are never touched never take
+  * any memory.
+  */
+ static void set_up(int idx) {
+     if (hashed) {
+         fa_init_set(&fa, idx);
+     } else {
+         lru_stack_t stack;
+         lru_stack_init_at(&stack, ways, &lru_ranks[(size_t) idx * ways]); // created to keep track of Least Recently Used data
+     }
+     set_ready[idx >> 6] |= 1ULL << (idx & 63);
+ }
+
+ /**
+  * Function to get the view of set <idx> in the arena.
+  */
+ static inline cache_set_t get_set(int idx) {
+     if (!(set_ready[idx >> 6] & (1ULL << (idx & 63)))) {
+         set_up(idx);
+     }
+     cache_set_t set;
+     set.size = ways;
+     set.index = idx;
+     set.mru = &mru_ways[idx];
+     set.stack.size = ways;
+     set.stack.indicies = &lru_ranks[(size_t) idx * ways];
+     set.blocks = &lines[(size_t) idx * ways];
+     return set;
+ }
  
-     // Set The Tag, Valid, and Dirty Bits of the cache block
-     // SET THE TAG, VALID, AND DIRTY LOCALS OF THE CACHE SET
- 
-     // cache_block_t new_cache = (cache_set_t*)malloc(sizeof(cache_set_t)); // create a cache block
-     // cache->dirty = 0; // a new cache line will always have an initial dirty bit equal to 0
-     // cache->valid = 1; // a new cache line will always have an initial vlaid bit equal to 1 
-     // cache->tag = 128 - num_index_bits - simple_log_2(128); // compute the number of tags
- 
-     cache = (cache_set_t*)malloc(sizeof(cache_set_t) * num_sets); // space for all sets
-     for (int i = 0; i < num_sets; i++) {
-         cache[i].blocks = (cache_block_t*)malloc(sizeof(cache_block_t) * ways); // create cache block for this cache set
-         cache[i].stack = init_lru_stack(ways); // created to keep track of Least Recently Used data
-         cache[i].size = ways;
+ /**
+  * Function to record where the access to <block> left it, for the redundant-access
+  * filter.
+  */
+ static inline void remember(addr_t block, cache_block_t* line, int way) {
+     last_block = block;
+     last_line = line;
+     last_way = way;
+ }
+
+ /**
+  * Function to forget the last block, e.g. when the cache state is replaced.
+  */
+ static inline void forget() {
+     last_block = NO_BLOCK;
+     last_line = NULL;
+ }
+
+ /**
+  * Function to apply a repeat access to the last block: set its dirty bit on a write
+  * and, for a skewed cache, refresh its timestamp. Nothing else can change in the LRU
+  * state because the block is already the MRU block of its set. Under an RRIP policy
+  * the repeat is a hit like any other.
+  */
+ static inline void filter_touch(int access_type) {
+     last_line->dirty |= (access_type == MEMWRITE);
+     if (index_fn == INDEX_SKEW) {
+         stamps[last_line - lines] = ++clock_stamp;
+     } else if (policy_kind != POLICY_LRU) {
+         rrip_hit(last_line);
+     } else if (deadblock_kind == DEADBLOCK_BYPASS) {
+         last_line->flags |= BLOCK_REUSED;
+     }
+ }
+
+ /**
+  * Function to intialize your cache simulator with the given cache parameters. 
+  * Note that we will only input valid parameters. The block size is a power of 2,
+  * but the number of sets and the associativity need not be (see cachesim_check_geometry).
+  * 
+  * @param _block_size is the block size in bytes
+  * @param _cache_size is the cache size in bytes
+  * @param _ways is the associativity
+  */
+ void cachesim_init(int _block_size, long long _cache_size, int _ways) {
+     set_geometry(_block_size, _cache_size, _ways);
+
+     // Lay out the arena: header, blocks, tags, timestamps, LRU ranks, MRU ways, set
+     // bitmap, SHCT, the LRU lists and hash of the hashed lookup, which replace the
+     // LRU ranks, the stream of each block when --mix shares the cache, then the PC
+     // way predictor's table. Sections a configuration does not use are empty.
+     size_t n = (size_t) num_sets * ways;
+     int hash_bits = hashed ? fa_hash_bits(n) : 0;
+     int tag_bytes = tag_bytes_for(tag_bits);
+     size_t lines_offset = STATE_ALIGN(sizeof(cache_state_t));
+     size_t tags_offset = STATE_ALIGN(lines_offset + n * sizeof(cache_block_t));
+     size_t stamps_offset = STATE_ALIGN(tags_offset + n * tag_bytes);
+     size_t ranks_offset = STATE_ALIGN(stamps_offset + (index_fn == INDEX_SKEW ? n * sizeof(counter_t) : 0));
+     size_t mru_offset = STATE_ALIGN(ranks_offset + (hashed ? 0 : n * sizeof(int)));
+     size_t ready_offset = STATE_ALIGN(mru_offset + (size_t) num_sets * sizeof(int));
+     size_t shct_offset = STATE_ALIGN(ready_offset + ((size_t) num_sets + 63) / 64 * sizeof(unsigned long long));
+     size_t links_offset = STATE_ALIGN(shct_offset + (policy_kind == POLICY_SHIP ? SHIP_SHCT_ENTRIES : 0));
+     size_t lists_offset = STATE_ALIGN(links_offset + (hashed ? n * sizeof(fa_link_t) : 0));
+     size_t slots_offset = STATE_ALIGN(lists_offset + (hashed ? (size_t) num_sets * sizeof(fa_list_t) : 0));
+     size_t streams_offset = STATE_ALIGN(slots_offset + (hashed ? (sizeof(unsigned) << hash_bits) : 0));
+     size_t pc_table_offset = STATE_ALIGN(streams_offset + (partition_streams > 1 ? n : 0));
+     size_t size = STATE_ALIGN(pc_table_offset + (waypred_kind == WAYPRED_PC ? WAYPRED_PC_ENTRIES * sizeof(int) : 0));
+
+     cache_state_t* s = (cache_state_t*) checkpoint_alloc(size);
+     if (!s) {
+         exit(1);
+     }
+     memcpy(s->magic, CACHE_STATE_MAGIC, sizeof(s->magic));
+     s->version = CACHE_STATE_VERSION;
+     s->block_size = block_size;
+     s->cache_size = cache_size;
+     s->ways = ways;
+     s->num_sets = num_sets;
+     s->index_fn = index_fn;
+     s->policy = policy_kind;
+     s->waypred = waypred_kind;
+     s->hashed = hashed;
+     s->hash_bits = hash_bits;
+     s->addr_bits = addr_bits;
+     s->tag_bytes = tag_bytes;
+     s->size = size;
+     s->lines_offset = lines_offset;
+     s->tags_offset = tags_offset;
+     s->stamps_offset = stamps_offset;
+     s->ready_offset = ready_offset;
+     s->ranks_offset = ranks_offset;
+     s->mru_offset = mru_offset;
+     s->shct_offset = shct_offset;
+     s->links_offset = links_offset;
+     s->lists_offset = lists_offset;
+     s->slots_offset = slots_offset;
+     s->streams_offset = streams_offset;
+     s->pc_table_offset = pc_table_offset;
+     state_attach(s);
+     forget();
+
+     // Every block starts out invalid and clean, which the zero pages already are, and
+     // each set gets its replacement order when it is first touched (see set_up)
+     if (policy_kind == POLICY_SHIP) {
+         memset(ship_shct, SHIP_COUNTER_INIT, SHIP_SHCT_ENTRIES);
+     }
+ }
+
+ /**
+  * Function to write the cache state and statistics to the checkpoint file <path>.
+  *
+  * @param path is the checkpoint file to write
+  * @param trace_lines is the number of trace lines consumed so far
+  * @param trace_pos is the byte offset of the next trace line
+  * @return 0 on success, -1 on error
+  */
+ int cachesim_checkpoint(const char* path, counter_t trace_lines, long long trace_pos) {
+     state->accesses = accesses;
+     state->hits = hits;
+     state->misses = misses;
+     state->writebacks = writebacks;
+     state->relocations = relocations;
+     state->clock_stamp = clock_stamp;
+     state->waypred_first = waypred_first;
+     state->waypred_second = waypred_second;
+     state->waypred_missed = waypred_missed;
+     state->ship_fills = ship_fills;
+     state->ship_dead_fills = ship_dead_fills;
+     state->ship_dead_correct = ship_dead_correct;
+     state->ship_dead_wrong = ship_dead_wrong;
+     state->ship_live_correct = ship_live_correct;
+     state->ship_live_wrong = ship_live_wrong;
+     state->trace_lines = trace_lines;
+     state->trace_pos = trace_pos;
+     return checkpoint_write(path, state, state->size);
+ }
+
+ /**
+  * Function to initialize the cache simulator from the checkpoint file <path> instead
+  * of an empty cache. The checkpoint is mapped as the cache state, so nothing is
+  * copied or rebuilt. The cache parameters must match the ones it was taken with.
+  *
+  * @param path is the checkpoint file to restore
+  * @param _block_size is the block size in bytes
+  * @param _cache_size is the cache size in bytes
+  * @param _ways is the associativity
+  * @param trace_lines is set to the number of trace lines consumed at the checkpoint
+  * @param trace_pos is set to the byte offset of the next trace line
+  * @return 0 on success, -1 on error
+  */
+ int cachesim_restore(const char* path, int _block_size, long long _cache_size, int _ways,
+                      counter_t* trace_lines, long long* trace_pos) {
+     set_geometry(_block_size, _cache_size, _ways);
+
+     size_t size;
+     cache_state_t* s = (cache_state_t*) checkpoint_map(path, &size);
+     if (!s) {
+         return -1;
+     }
+     if (size < sizeof(cache_state_t) || memcmp(s->magic, CACHE_STATE_MAGIC, sizeof(s->magic)) != 0
+         || s->version != CACHE_STATE_VERSION || s->size != size) {
+         fprintf(stderr, "%s is not a cache checkpoint\n", path);
+         checkpoint_unmap(s, size);
+         return -1;
+     }
+     if (s->block_size != block_size || s->cache_size != cache_size || s->ways != ways
+         || s->index_fn != index_fn || s->policy != policy_kind || s->waypred != waypred_kind
+         || s->hashed != hashed || s->addr_bits != addr_bits) {
+         fprintf(stderr, "Checkpoint was taken with %d %lld %d --index=%s --policy=%s --waypred=%s --addr-bits=%d"
+                         " (%s lookup)\n",
+                 s->block_size, s->cache_size, s->ways, index_name(s->index_fn), policy_name(s->policy),
+                 waypred_name(s->waypred), s->addr_bits, s->hashed ? "hashed" : "scanned");
+         checkpoint_unmap(s, size);
+         return -1;
+     }
+     state_attach(s);
+     forget();
+
+     accesses = s->accesses;
+     hits = s->hits;
+     misses = s->misses;
+     writebacks = s->writebacks;
+     relocations = s->relocations;
+     clock_stamp = s->clock_stamp;
+     waypred_first = s->waypred_first;
+     waypred_second = s->waypred_second;
+     waypred_missed = s->waypred_missed;
+     ship_fills = s->ship_fills;
+     ship_dead_fills = s->ship_dead_fills;
+     ship_dead_correct = s->ship_dead_correct;
+     ship_dead_wrong = s->ship_dead_wrong;
+     ship_live_correct = s->ship_live_correct;
+     ship_live_wrong = s->ship_live_wrong;
+     *trace_lines = s->trace_lines;
+     *trace_pos = s->trace_pos;
+     return 0;
+ }
+
+ /**
+  * Function to reset every statistic, e.g. at the end of the warm-up window. The
+  * cache contents are kept.
+  */
+ void cachesim_reset_stats() {
+     accesses = 0;
+     hits = 0;
+     misses = 0;
+     writebacks = 0;
+     relocations = 0;
+     filtered = 0;
+     waypred_reset_stats();
+     policy_reset_stats();
+     partition_reset_stats();
+     if (deadblock_kind != DEADBLOCK_NONE) {
+         deadblock_reset_stats();
+     }
+     if (nuca_kind != NUCA_NONE) {
+         nuca_reset_stats();
+     }
+     if (misstrace_enabled) {
+         misstrace_reset_stats();
+     }
+     if (dram_enabled) {
+         dram_reset_stats();
+     }
+     if (tlb_enabled) {
+         tlb_reset_stats();
+     }
+ }
  
-         // Initial values of new blocks in cache
-         for (int b = 0; b < ways; b++) {
-             cache[i].blocks[b].dirty = 0; // initially 0
-             cache[i].blocks[b].valid = 0; // initially 0, I thought it was 1???
-             cache[i].blocks[b].tag = -1;  // initially -1? i thought it was 128 - num_index_bits - simple_log_2(128)??
+ /**
+  * Function to get the block address of <physical_addr>, i.e. its lower <addr_bits>
+  * bits (32 by default) without the offset bits.
+  */
+ static inline addr_t block_address(addr_t physical_addr) {
+     return (physical_addr & addr_mask) >> num_offset_bits;
+ }
+
+ /**
+  * Function to get the set <block> maps to with the selected index function.
+  * Not used for INDEX_SKEW, which has one set per way.
+  */
+ static inline int set_of(addr_t block) {
+     switch (index_fn) {
+     case INDEX_XOR:
+         return (int) index_xor_fold(block, num_index_bits);
+     case INDEX_PRIME:
+     case INDEX_MODULO:
+         return (int) fastmod_u64(block, set_mod);
+     default:
+         return (int) (block & ((1ULL << num_index_bits) - 1));
+     }
+ }
+
+ /**
+  * Function to get the tag of <block>. Together with the set it must identify the
+  * block, so the modulo index functions keep the quotient instead of the upper bits.
+  */
+ static inline tag_t tag_of(addr_t block) {
+     if (index_fn == INDEX_PRIME || index_fn == INDEX_MODULO) {
+         return fastdiv_u64(block, set_mod);
+     }
+     return block >> num_index_bits;
+ }
+
+ /**
+  * Function to get the block address back from the <set> and <tag> it is stored
+  * under, e.g. to write back a victim. A skewed cache keeps the whole block address
+  * as the tag, and the XOR fold of the tag bits is undone to recover the index bits.
+  */
+ static inline addr_t block_of(int set, tag_t tag) {
+     addr_t upper = tag;
+     switch (index_fn) {
+     case INDEX_SKEW:
+         return upper;
+     case INDEX_PRIME:
+     case INDEX_MODULO:
+         return upper * (addr_t) set_mod.d + (addr_t) set;
+     case INDEX_XOR:
+         return (upper << num_index_bits) | ((addr_t) set ^ index_xor_fold(upper << num_index_bits, num_index_bits));
+     default:
+         return (upper << num_index_bits) | (addr_t) set;
+     }
+ }
+
+ /**
+  * Function to send a miss on <block> to the next level, i.e. the miss trace and the
+  * DRAM model: the fill request and, if the victim was dirty, the writeback of <victim>.
+  */
+ static inline void emit_miss(addr_t block, int access_type, addr_t pc, int dirty_victim, addr_t victim) {
+     if (misstrace_enabled) {
+         misstrace_emit(access_type == IFETCH ? IFETCH : MEMREAD, block << num_offset_bits, pc, trace_index);
+         if (dirty_victim) {
+             misstrace_emit(MEMWRITE, victim << num_offset_bits, pc, trace_index);
+         }
+     }
+     if (dram_enabled) {
+         dram_access(block << num_offset_bits, 0, trace_index);
+         if (dirty_victim) {
+             dram_access(victim << num_offset_bits, 1, trace_index);
          }
      }
-     
-     ////////////////////////////////////////////////////////////////////
-     //  End of your code   
-     ////////////////////////////////////////////////////////////////////
  }
- 
+
+ /**
+  * Candidate position in the zcache replacement walk. <parent> is the candidate
+  * whose block would move into this position if this one is chosen as victim.
+  */
+ typedef struct zcache_cand_t {
+     int set;
+     int way;
+     int parent;
+ } zcache_cand_t;
+
+ /**
+  * Function to check whether position (<set>, <way>) is already on the path from
+  * candidate <i> back to the first level, so a relocation never moves a block twice.
+  */
+ static int zcache_on_path(zcache_cand_t* cand, int i, int set, int way) {
+     for (; i >= 0; i = cand[i].parent) {
+         if (cand[i].set == set && cand[i].way == way) {
+             return 1;
+         }
+     }
+     return 0;
+ }
+
+ /**
+  * Function to perform an access on a skewed-associative cache. Each way is indexed
+  * with its own hash, and the tag is the whole block address so a block can be
+  * rehashed into any other way.
+  *
+  * On a miss the zcache walk expands the candidates: the block in each first-level
+  * position could move to its own position in every other way, freeing the first
+  * level slot. The least recently used block among all candidates is evicted and the
+  * blocks along its path are shifted down so the new block lands in the first level.
+  */
+ static void access_skewed(addr_t block, int access_type, addr_t pc) {
+     static zcache_cand_t cand[ZCACHE_MAX_CANDIDATES];
+     clock_stamp++;
+
+     // check for a cache hit in each way's set
+     for (int w = 0; w < ways; w++) {
+         size_t l = LINE_INDEX(index_skew(block, w, num_index_bits), w);
+         if (lines[l].valid && tag_get(&tags, l) == block) {
+             hits++;
+             if (access_type == MEMWRITE) {
+                 lines[l].dirty = 1;
+             }
+             stamps[l] = clock_stamp;
+             remember(block, &lines[l], w);
+             return;
+         }
+     }
+     misses++;
+
+     // Build the candidate tree level by level
+     int n = 0;
+     for (int w = 0; w < ways; w++) {
+         cand[n].set = (int) index_skew(block, w, num_index_bits);
+         cand[n].way = w;
+         cand[n].parent = -1;
+         n++;
+     }
+     int level_start = 0;
+     int level_end = n;
+     for (int level = 1; level < zcache_levels; level++) {
+         for (int i = level_start; i < level_end; i++) {
+             size_t l = LINE_INDEX(cand[i].set, cand[i].way);
+             if (!lines[l].valid) {
+                 continue; // Free slot, nothing needs to move out of it
+             }
+             tag_t resident = tag_get(&tags, l);
+             for (int w = 0; w < ways && n < ZCACHE_MAX_CANDIDATES; w++) {
+                 int s = (int) index_skew(resident, w, num_index_bits);
+                 if (w == cand[i].way || zcache_on_path(cand, i, s, w)) {
+                     continue;
+                 }
+                 cand[n].set = s;
+                 cand[n].way = w;
+                 cand[n].parent = i;
+                 n++;
+             }
+         }
+         level_start = level_end;
+         level_end = n;
+     }
+
+     // Victim is the first invalid candidate, otherwise the least recently used
+     int victim = 0;
+     for (int i = 0; i < n; i++) {
+         size_t l = LINE_INDEX(cand[i].set, cand[i].way);
+         if (!lines[l].valid) {
+             victim = i;
+             break;
+         }
+         if (stamps[l] < stamps[LINE_INDEX(cand[victim].set, cand[victim].way)]) {
+             victim = i;
+         }
+     }
+
+     size_t v = LINE_INDEX(cand[victim].set, cand[victim].way);
+     if (lines[v].valid && lines[v].dirty) {
+         writebacks++;
+     }
+     if (misstrace_enabled || dram_enabled) {
+         emit_miss(block, access_type, pc, lines[v].valid && lines[v].dirty, tag_get(&tags, v));
+     }
+
+     // Shift the blocks on the victim's path down one level
+     int i = victim;
+     while (cand[i].parent >= 0) {
+         int p = cand[i].parent;
+         size_t to = LINE_INDEX(cand[i].set, cand[i].way);
+         size_t from = LINE_INDEX(cand[p].set, cand[p].way);
+         lines[to] = lines[from];
+         tag_put(&tags, to, tag_get(&tags, from));
+         stamps[to] = stamps[from];
+         relocations++;
+         i = p;
+     }
+
+     size_t l = LINE_INDEX(cand[i].set, cand[i].way);
+     tag_put(&tags, l, block);
+     lines[l].valid = 1;
+     lines[l].dirty = (access_type == MEMWRITE);
+     stamps[l] = clock_stamp;
+     remember(block, &lines[l], cand[i].way);
+ }
+
+ /**
+  * Function to mark way <w> of <set> as MRU. When <w> already is the MRU way the LRU
+  * stack would not change, so the O(ways) update is skipped. The RRIP policies keep
+  * the MRU way for the lookup but have no LRU stack to update.
+  */
+ static inline void promote(cache_set_t* set, int w) {
+     if (*set->mru != w) {
+         if (policy_kind == POLICY_LRU) {
+             if (hashed) {
+                 fa_touch(&fa, set->index, w);
+             } else {
+                 lru_stack_set_mru(&set->stack, w);
+             }
+         }
+         *set->mru = w;
+     }
+ }
+
+ /**
+  * Function to mark way <w> of <set> as LRU, for a fill inserted with low priority.
+  * Only used with the scanned LRU stack.
+  */
+ static void demote(cache_set_t* set, int w) {
+     int* ranks = set->stack.indicies;
+     for (int v = 0; v < ways; v++) {
+         if (ranks[v] > ranks[w]) {
+             ranks[v]--;
+         }
+         if (ranks[v] == 0 && v != w) {
+             *set->mru = v;
+         }
+     }
+     ranks[w] = ways - 1;
+ }
+
+ /**
+  * Function to find the way of <set> holding <tag_bit>, probing way <first> before
+  * the rest of the set. A hashed cache goes straight to the hash.
+  *
+  * @return the way that hit, or -1 on a miss
+  */
+ static inline int find_way(cache_set_t* set, tag_t tag_bit, int first) {
+     if (hashed) {
+         return fa_lookup(&fa, set->index, tag_bit);
+     }
+     size_t base = LINE_INDEX(set->index, 0);
+     if ((set->blocks[first].valid == 1) && (tag_get(&tags, base + first) == tag_bit)) {
+         return first;
+     }
+     for (int w = 0; w < ways; w++) {
+         if ((w != first) && (set->blocks[w].valid == 1) && (tag_get(&tags, base + w) == tag_bit)) {
+             return w;
+         }
+     }
+     return -1;
+ }
+
+ /**
+  * Function to pick the victim of a full <set> in a partitioned cache: the least
+  * recently used block of the streams the current stream may evict (see partition.h).
+  */
+ static int partition_victim(cache_set_t* set) {
+     unsigned char evictable[PARTITION_MAX_STREAMS];
+     const unsigned char* streams = &block_streams[LINE_INDEX(set->index, 0)];
+     partition_evictable(streams, ways, evictable);
+     if (hashed) {
+         fa_link_t* links = &fa.links[(size_t) set->index * ways];
+         int w = fa.lists[set->index].tail;
+         while (!evictable[streams[w]]) {
+             w = links[w].prev;
+         }
+         return w;
+     }
+     int victim = 0, rank = -1;
+     for (int w = 0; w < ways; w++) {
+         if (evictable[streams[w]] && set->stack.indicies[w] > rank) {
+             victim = w;
+             rank = set->stack.indicies[w];
+         }
+     }
+     return victim;
+ }
+
+ /**
+  * Function to pick the way of <set> to fill on a miss: the first invalid block, or
+  * the replacement policy's victim once all blocks are valid. A hashed cache knows
+  * both without a scan under LRU.
+  */
+ static inline int victim_way(cache_set_t* set) {
+     if (hashed) {
+         fa_list_t* l = &fa.lists[set->index];
+         if (l->filled < ways) {
+             return l->filled++;
+         }
+         if (partition_kind != PARTITION_NONE) {
+             return partition_victim(set);
+         }
+         return (policy_kind == POLICY_LRU) ? l->tail : rrip_victim(set->blocks, ways);
+     }
+     for (int w = 0; w < ways; w++) {
+         if (set->blocks[w].valid == 0) {
+             return w;
+         }
+     }
+     if (policy_kind != POLICY_LRU) {
+         return rrip_victim(set->blocks, ways);
+     }
+     if (partition_kind != PARTITION_NONE) {
+         return partition_victim(set);
+     }
+     return lru_stack_get_lru(&set->stack);
+ }
+
+ /**
+  * Function to pick the way of <set> to fill on a miss in a D-NUCA cache: the first
+  * invalid block of the farthest bank, or its least recently used block.
+  */
+ static int nuca_victim(cache_set_t* set) {
+     int victim = ways - nuca_group_ways, rank = -1;
+     for (int w = ways - nuca_group_ways; w < ways; w++) {
+         if (set->blocks[w].valid == 0) {
+             return w;
+         }
+         if (set->stack.indicies[w] > rank) {
+             victim = w;
+             rank = set->stack.indicies[w];
+         }
+     }
+     return victim;
+ }
+
+ /**
+  * Function to move the block in way <w> of <set>, which just hit, one bank closer in
+  * a D-NUCA cache by swapping it with an invalid block of that bank, or else its least
+  * recently used block. Each block keeps its tag, state and LRU position.
+  *
+  * @return the way the block is in afterwards
+  */
+ static int nuca_migrate(cache_set_t* set, int w) {
+     int first = (w / nuca_group_ways - 1) * nuca_group_ways;
+     int to = first, rank = -1;
+     for (int v = first; v < first + nuca_group_ways; v++) {
+         if (set->blocks[v].valid == 0) {
+             to = v;
+             rank = set->stack.indicies[v];
+             break;
+         }
+         if (set->stack.indicies[v] > rank) {
+             to = v;
+             rank = set->stack.indicies[v];
+         }
+     }
+     size_t base = LINE_INDEX(set->index, 0);
+     cache_block_t block = set->blocks[w];
+     set->blocks[w] = set->blocks[to];
+     set->blocks[to] = block;
+     tag_t tag = tag_get(&tags, base + w);
+     tag_put(&tags, base + w, tag_get(&tags, base + to));
+     tag_put(&tags, base + to, tag);
+     set->stack.indicies[to] = set->stack.indicies[w];
+     set->stack.indicies[w] = rank;
+     if (*set->mru == to) {
+         *set->mru = w;
+     }
+     nuca_migrations++;
+     nuca_moved_blocks += 1 + set->blocks[w].valid;
+     return to;
+ }
+
+ /**
+  * Function to put the block <tag_bit> into way <w> of <set>, in place of whatever
+  * block was there.
+  */
+ static inline void replace_block(cache_set_t* set, int w, tag_t tag_bit, int access_type) {
+     unsigned line = (unsigned) LINE_INDEX(set->index, w);
+     if (hashed && set->blocks[w].valid) {
+         fa_remove(&fa, set->index, line);
+     }
+     tag_put(&tags, line, tag_bit);
+     set->blocks[w].valid = 1;
+     set->blocks[w].dirty = (access_type == MEMWRITE);
+     if (partition_streams > 1) {
+         block_streams[line] = (unsigned char) partition_stream;
+     }
+     if (hashed) {
+         fa_insert(&fa, set->index, line);
+     }
+ }
+
  /**
   * Function to perform a SINGLE memory access to your cache. In this function, 
   * you will need to update the required statistics (accesses, hits, misses, writebacks)
@@ -103,83 +843,199 @@
   *      to reflect these values in cachesim.h so you can make your code more readable.
   */
  void cachesim_access(addr_t physical_addr, int access_type) {
+     cachesim_access_pc(physical_addr, access_type, 0);
+ }
+
+ /**
+  * Function to perform a SINGLE memory access made by the instruction at <pc>. Same as
+  * cachesim_access, but the instruction address is available to the predictors.
+  *
+  * @param physical_addr is the address to use for the memory access.
+  * @param access_type is the type of access (MEMREAD, MEMWRITE or IFETCH)
+  * @param pc is the address of the instruction making the access
+  */
+ void cachesim_access_pc(addr_t physical_addr, int access_type, addr_t pc) {
      accesses++; // global inc
-     ////////////////////////////////////////////////////////////////////
-     //  TODO: Write the code needed to perform a cache access on your
-     //  cache simulator. Some things to remember:
-     //      - When it is a cache hit, you SHOULD NOT bring another cache 
-     //        block in.
-     //      - When it is a cache miss, you should bring a new cache block
-     //        in. If the set is full, evict the LRU block.
-     //      - Remember to update all the necessary statistics as necessary
-     //      - Remember to correctly update your valid and dirty bits.  
-     ////////////////////////////////////////////////////////////////////
- 
-     // 1st we should get the specific offset, index and tag bits from the address
-     int off_bit = physical_addr & ((1 << num_offset_bits) - 1);
-     int idx_bit = (physical_addr >> num_offset_bits) & ((1 << num_index_bits) - 1);
-     int tag_bit = (physical_addr >> (num_offset_bits + num_index_bits)) & ((1 << (32 - num_offset_bits - num_index_bits)) - 1);
- 
-     // check for a cache hit
-     for(int w = 0; w < ways; w++) {
-         if ((cache[idx_bit].blocks[w].tag == tag_bit) && (cache[idx_bit].blocks[w].valid == 1)) {
-             hits++;
- 
-             // Write access -> dirty bit = 1
-             if (access_type == MEMWRITE) {
-                 cache[idx_bit].blocks[w].dirty = 1;
+
+     // Translation runs alongside the lookup, on the address before the page map
+     if (tlb_enabled) {
+         tlb_access(physical_addr & addr_mask, access_type);
+     }
+
+     // Trace addresses are virtual when the page map is on, see pagemap.h
+     if (pagemap_kind != PAGEMAP_NONE) {
+         physical_addr = pagemap_translate(physical_addr);
+     }
+
+     // 1st we should get the specific index and tag bits from the address
+     addr_t block = block_address(physical_addr);
+     if (partition_kind == PARTITION_UCP) {
+         ucp_observe(set_of(block), block);
+     }
+     if (filter_enabled && block == last_block) {
+         hits++;
+         filtered++;
+         filter_touch(access_type);
+         if (waypred_kind != WAYPRED_NONE) {
+             int pred = (waypred_kind == WAYPRED_PC) ? waypred_pc_table[waypred_pc_slot(pc)] : last_way;
+             waypred_update(pc, pred, last_way, last_way);
+         }
+         return;
+     }
+     if (index_fn == INDEX_SKEW) {
+         access_skewed(block, access_type, pc);
+         return;
+     }
+     int idx_bit = set_of(block);
+     tag_t tag_bit = tag_of(block);
+     cache_set_t set_view = get_set(idx_bit);
+     cache_set_t* set = &set_view;
+
+     // check for a cache hit, probing the predicted way before the rest of the set
+     int pred = (waypred_kind == WAYPRED_PC) ? waypred_pc_table[waypred_pc_slot(pc)] : *set->mru;
+     int hit_way = find_way(set, tag_bit, pred);
+
+     if (hit_way >= 0) {
+         hits++;
+         int final_way = hit_way;
+         if (nuca_kind != NUCA_NONE) {
+             nuca_hit(idx_bit, hit_way);
+             if (nuca_kind == NUCA_DYNAMIC && hit_way >= nuca_group_ways) {
+                 final_way = nuca_migrate(set, hit_way);
              }
- 
-             // Must adjust the LRU stack 
-             lru_stack_set_mru(cache[idx_bit].stack, w);
- 
-             // Return to skip unecessary processes
-             return;
          }
+
+         // Write access -> dirty bit = 1
+         if (access_type == MEMWRITE) {
+             set->blocks[final_way].dirty = 1;
+         }
+
+         // Must adjust the LRU stack
+         promote(set, final_way);
+         if (policy_kind != POLICY_LRU) {
+             rrip_hit(&set->blocks[final_way]);
+         } else if (deadblock_kind == DEADBLOCK_BYPASS) {
+             set->blocks[final_way].flags |= BLOCK_REUSED;
+         }
+         remember(block, &set->blocks[final_way], final_way);
+         if (waypred_kind != WAYPRED_NONE) {
+             waypred_update(pc, pred, hit_way, final_way);
+         }
+         return;
      }
      // No hit so Cache miss!!
      misses++;
- 
-     // Invalid block check
-     for (int w = 0; w < ways; w++) {
-         if (cache[idx_bit].blocks[w].valid == 0) {
-             // invalid block located
-             cache[idx_bit].blocks[w].tag = tag_bit; // set tag
-             cache[idx_bit].blocks[w].valid = 1;     // set valid
-             // Memory Write Check
-             if (access_type == MEMWRITE) {
-                 cache[idx_bit].blocks[w].dirty = 1;
+
+     // Check Writeback counter increment
+     int fill = (nuca_kind == NUCA_DYNAMIC) ? nuca_victim(set) : victim_way(set);
+     if (nuca_kind != NUCA_NONE) {
+         nuca_miss(idx_bit, fill);
+     }
+     if (deadblock_kind != DEADBLOCK_NONE) {
+         deadblock_fills++;
+         // An invalid way costs nothing to fill, so only a real victim is spared
+         if (deadblock_kind == DEADBLOCK_BYPASS && access_type != MEMWRITE && set->blocks[fill].valid
+             && deadblock_bypass(pc)) {
+             // Predicted dead on arrival: the block only passes through, and the
+             // would-be victim stays
+             deadblock_bypassed++;
+             deadblock_saved += set->blocks[fill].dirty;
+             if (misstrace_enabled || dram_enabled) {
+                 emit_miss(block, access_type, pc, 0, 0);
              }
-             // Adjust LRU
-             lru_stack_set_mru(cache[idx_bit].stack, w);
- 
+             forget();
              return;
          }
+         if (deadblock_kind == DEADBLOCK_BYPASS && set->blocks[fill].valid) {
+             deadblock_evict(&set->blocks[fill]);
+         }
      }
- 
-     // Evict LRU block since all blocks are valid
-     int lru_idx = lru_stack_get_lru(cache[idx_bit].stack);
- 
-     // Check Writeback counter increment
-     if ((cache[idx_bit].blocks[lru_idx].dirty == 1) && (cache[idx_bit].blocks[lru_idx].valid == 1)) {
+     if ((set->blocks[fill].dirty == 1) && (set->blocks[fill].valid == 1)) {
          writebacks++;
-         // after WB, reset dirty bit to 0
-         cache[idx_bit].blocks[lru_idx].dirty = 0;
      }
-     // LRU block with new tag
-     cache[idx_bit].blocks[lru_idx].tag = tag_bit;
-     // cache[idx_bit].blocks[lru_idx].valid = 1; // set valid to 1?
- 
-     // Update MRU on updating LRU
-     lru_stack_set_mru(cache[idx_bit].stack, lru_idx);
+     if (misstrace_enabled || dram_enabled) {
+         emit_miss(block, access_type, pc, set->blocks[fill].dirty && set->blocks[fill].valid,
+                   block_of(idx_bit, tag_get(&tags, LINE_INDEX(idx_bit, fill))));
+     }
+     if (policy_kind == POLICY_SHIP && set->blocks[fill].valid) {
+         ship_record(&set->blocks[fill]);
+         ship_evict(&set->blocks[fill]);
+     }
+
+     // Bring the new block in, dirty only if this access writes it
+     replace_block(set, fill, tag_bit, access_type);
+     if (policy_kind != POLICY_LRU) {
+         ship_dead_fills += rrip_fill(&set->blocks[fill], pc);
+         ship_fills++;
+     } else if (deadblock_kind == DEADBLOCK_BYPASS) {
+         set->blocks[fill].signature = deadblock_slot(pc);
+         set->blocks[fill].flags = 0;
+     }
+     if (deadblock_kind == DEADBLOCK_DIP && dip_fill(idx_bit)) {
+         // Inserted with low priority, so it is not the MRU block the filter expects
+         demote(set, fill);
+         deadblock_low++;
+         forget();
+     } else {
+         promote(set, fill);
+         remember(block, &set->blocks[fill], fill);
+     }
+     if (waypred_kind != WAYPRED_NONE) {
+         waypred_update(pc, pred, -1, fill);
+     }
+ }
  
-     // Check access type for lru index
-     if (access_type == MEMWRITE) {
-         cache[idx_bit].blocks[lru_idx].dirty = 1;
+ /**
+  * Function to perform the functional warming version of an access. Tags, replacement
+  * state (including the SHiP predictor) and dirty bits change exactly as they would in
+  * cachesim_access_pc, but no statistic is counted and the way predictor is not trained.
+  *
+  * @param physical_addr is the address to use for the memory access.
+  * @param access_type is the type of access (MEMREAD, MEMWRITE or IFETCH)
+  * @param pc is the address of the instruction making the access
+  */
+ void cachesim_warm(addr_t physical_addr, int access_type, addr_t pc) {
+     if (pagemap_kind != PAGEMAP_NONE) {
+         physical_addr = pagemap_translate(physical_addr);
      }
-     ////////////////////////////////////////////////////////////////////
-     //  End of your code   
-     ////////////////////////////////////////////////////////////////////
+     addr_t block = block_address(physical_addr);
+     if (filter_enabled && block == last_block) {
+         filter_touch(access_type);
+         return;
+     }
+     if (index_fn == INDEX_SKEW) {
+         // The zcache walk is the cost either way, so run it and put the counters back
+         counter_t saved_hits = hits, saved_misses = misses;
+         counter_t saved_writebacks = writebacks, saved_relocations = relocations;
+         access_skewed(block, access_type, pc);
+         hits = saved_hits;
+         misses = saved_misses;
+         writebacks = saved_writebacks;
+         relocations = saved_relocations;
+         return;
+     }
+     tag_t tag_bit = tag_of(block);
+     cache_set_t set_view = get_set(set_of(block));
+     cache_set_t* set = &set_view;
+
+     int w = find_way(set, tag_bit, *set->mru);
+     if (w >= 0) {
+         set->blocks[w].dirty |= (access_type == MEMWRITE);
+         if (policy_kind != POLICY_LRU) {
+             rrip_hit(&set->blocks[w]);
+         }
+     } else {
+         w = victim_way(set);
+         if (policy_kind == POLICY_SHIP && set->blocks[w].valid) {
+             ship_evict(&set->blocks[w]);
+         }
+         replace_block(set, w, tag_bit, access_type);
+         if (policy_kind != POLICY_LRU) {
+             rrip_fill(&set->blocks[w], pc);
+         }
+     }
+     promote(set, w);
+     remember(block, &set->blocks[w], w);
  }
  
  /**
@@ -189,11 +1045,16 @@
      ////////////////////////////////////////////////////////////////////
      //  TODO: Write the code to do any heap allocation cleanup
      ////////////////////////////////////////////////////////////////////
-     for (int i = 0; i < num_sets; i++) {
-         lru_stack_cleanup(cache[i].stack); // must free stack and block's first
-         free(cache[i].blocks);
-     }
-     free(cache); // free cache
+     // Blocks and LRU stacks live in the state arena, so there is one thing to free
+     checkpoint_unmap(state, state->size);
+     waypred_cleanup();
+     sampling_cleanup();
+     shards_cleanup();
+     pagemap_cleanup();
+     partition_cleanup();
+     dram_cleanup();
+     nuca_cleanup();
+     tlb_cleanup();
      ////////////////////////////////////////////////////////////////////
      //  End of your code   
      ////////////////////////////////////////////////////////////////////
@@ -207,6 +1068,110 @@
      printf("%llu, %llu, %llu, %llu\n", accesses, hits, misses, writebacks);  
  }
  
+ /**
+  * Function to print the reports of any optional features that were enabled.
+  * Prints nothing for a default run, so the stats line stays the only output.
+  */
+ void cachesim_print_report() {
+     if (index_fn != INDEX_BITSLICE) {
+         printf("index: %s", index_name(index_fn));
+         if (index_fn == INDEX_PRIME) {
+             printf(" (%d of %d sets used)", index_prime, num_sets);
+         } else if (index_fn == INDEX_SKEW) {
+             printf(" (zcache levels %d, relocations %llu)", zcache_levels, relocations);
+         }
+         printf(", miss rate %.4f%%\n", accesses ? 100.0 * misses / accesses : 0.0);
+     }
+     if (policy_kind != POLICY_LRU) {
+         policy_print_stats(accesses, misses);
+     }
+     if (waypred_kind != WAYPRED_NONE) {
+         waypred_print_stats();
+     }
+     if (sampling_active) {
+         sampling_print_stats();
+     }
+     if (mrc_enabled) {
+         shards_print_stats();
+     }
+     if (misstrace_enabled) {
+         misstrace_print_stats(accesses);
+     }
+     if (pagemap_kind != PAGEMAP_NONE) {
+         pagemap_print_stats(accesses, misses);
+     }
+     if (partition_streams > 1) {
+         partition_print_stats();
+     }
+     if (dram_enabled) {
+         dram_print_stats();
+     }
+     if (deadblock_kind != DEADBLOCK_NONE) {
+         counter_t plain_hits = 0, plain_writebacks = 0;
+         for (int i = 0; i < partition_streams; i++) {
+             plain_hits += stream_baseline[i].hits;
+             plain_writebacks += stream_baseline[i].writebacks;
+         }
+         deadblock_print_stats(accesses, hits, writebacks, plain_hits, plain_writebacks);
+     }
+     if (nuca_kind != NUCA_NONE) {
+         nuca_print_stats(block_size);
+     }
+     if (tlb_enabled) {
+         tlb_print_stats(accesses);
+     }
+     if (timeseries_enabled) {
+         timeseries_print_stats();
+     }
+     if (state_stats) {
+         printf("state: %d-bit addresses, %d-bit tags stored in %d bytes, %llu byte arena",
+                addr_bits, tag_bits, state->tag_bytes, state->size);
+         if (index_fn != INDEX_SKEW) {
+             int touched = 0;
+             for (int i = 0; i < (num_sets + 63) / 64; i++) {
+                 touched += __builtin_popcountll(set_ready[i]);
+             }
+             printf(", %d of %d sets touched", touched, num_sets);
+         }
+         printf("\n");
+     }
+     if (filter_stats) {
+         printf("filter: %llu of %llu accesses (%.4f%%) were repeats of the last block\n",
+                filtered, accesses, accesses ? 100.0 * filtered / accesses : 0.0);
+     }
+ }
+
+ /**
+  * Function to check that the cache parameters describe a cache the simulator can
+  * model: a power-of-2 block size and a whole number of sets. The number of sets and
+  * the associativity can be anything else, but the XOR-fold and skewed index functions
+  * need a power-of-2 number of sets.
+  *
+  * @return 0 if the parameters are valid, -1 otherwise
+  */
+ int cachesim_check_geometry(long long _block_size, long long _cache_size, long long _ways) {
+     if (_block_size < 1 || (_block_size & (_block_size - 1)) != 0 || (unsigned long long) _block_size >= (1ULL << (addr_bits - 1))) {
+         fprintf(stderr, "Block size must be a power of 2 smaller than the address space\n");
+         return -1;
+     }
+     if (_ways < 1 || _cache_size < _block_size * _ways || _cache_size % (_block_size * _ways) != 0) {
+         fprintf(stderr, "Cache size must be a whole number of sets of <ways> blocks\n");
+         return -1;
+     }
+     long long sets = _cache_size / (_block_size * _ways);
+     if (sets > 0x7FFFFFFF || sets * _ways >= 0xFFFFFFFFLL) {
+         fprintf(stderr, "At most 2^31 sets and 2^32 - 1 blocks are supported\n");
+         return -1;
+     }
+     if ((index_fn == INDEX_XOR || index_fn == INDEX_SKEW) && (sets & (sets - 1)) != 0) {
+         fprintf(stderr, "--index=%s needs a power-of-2 number of sets\n", index_name(index_fn));
+         return -1;
+     }
+     return 0;
+ }
+
+ #ifndef CACHESIM_NO_MAIN  // Defined when the simulator is built into cachesimd
+
  /**
   * Function to open the trace file
   * You do not need to update this function. 
@@ -215,6 +1180,40 @@
      return fopen(filename, "r");
  }
  
+ // 1 while the trace is simulated in detail, 0 while it only warms the cache
+ static int detailed = 1;
+
+ // Trace lines consumed, including the ones before a restored checkpoint
+ static counter_t trace_lines = 0;
+
+ /**
+  * Function to finish reading a trace line: the optional fourth column with the
+  * index of the access in the original trace (see misstrace.h), then the line break
+  * and any blank lines after it.
+  *
+  * @param trace is the file handler for the trace
+  * @return the index from the line, or the number of lines before it if there is none
+  */
+ static counter_t read_index(FILE* trace) {
+     counter_t index = trace_lines;
+     int c = getc(trace);
+     while (c == ' ' || c == '\t') {
+         c = getc(trace);
+     }
+     if (c >= '0' && c <= '9') {
+         ungetc(c, trace);
+         fscanf(trace, "%llu", &index);
+         c = getc(trace);
+     }
+     while (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+         c = getc(trace);
+     }
+     if (c != EOF) {
+         ungetc(c, trace);
+     }
+     return index;
+ }
+
  /**
   * Read in next line of the trace
   * 
@@ -226,12 +1225,100 @@
      else {
          int t;
          unsigned long long address, instr;
-         fscanf(trace, "%d %llx %llx\n", &t, &address, &instr);
-         cachesim_access(address, t);
+         fscanf(trace, "%d %llx %llx", &t, &address, &instr);
+         trace_index = read_index(trace);
+         if (mrc_enabled) {
+             shards_access(address >> num_offset_bits);
+         }
+         if (!detailed) {
+             cachesim_warm(address, t, instr);
+         } else if (timeseries_enabled) {
+             counter_t h = hits, m = misses, wb = writebacks;
+             cachesim_access_pc(address, t, instr);
+             timeseries_account(t, (int) (hits - h), (int) (misses - m), (int) (writebacks - wb));
+         } else {
+             cachesim_access_pc(address, t, instr);
+         }
      }
      return 1;
  }
  
+ // Streams sharing the cache, see partition.h. Stream 0 is the trace on the command
+ // line, the others come from --mix and are interleaved with it one access at a time.
+ static FILE* stream_traces[PARTITION_MAX_STREAMS];
+ static int num_streams = 1;
+ static int stream_turn = 0;     // Stream to read the next access from
+
+ /**
+  * Read in the next line of the next stream that has lines left, and charge the
+  * access to that stream.
+  *
+  * @return 0 when every stream has reached EOF and 1 otherwise.
+  */
+ static int next_mixed() {
+     for (int tried = 0; tried < num_streams; tried++) {
+         int s = stream_turn;
+         stream_turn = (s + 1 == num_streams) ? 0 : s + 1;
+         if (!stream_traces[s]) {
+             continue;
+         }
+         counter_t h = hits, m = misses, wb = writebacks;
+         partition_stream = s;
+         if (next_line(stream_traces[s])) {
+             stream_stats[s].accesses++;
+             stream_stats[s].hits += hits - h;
+             stream_stats[s].misses += misses - m;
+             stream_stats[s].writebacks += writebacks - wb;
+             return 1;
+         }
+         stream_traces[s] = NULL;
+     }
+     return 0;
+ }
+
+ /**
+  * Function to start the unpartitioned run of the streams in a child process, which
+  * sends the statistics of every stream back once it has read all of them.
+  *
+  * @param warmup is the number of accesses before the statistics are reset
+  * @return the end of the pipe to read the statistics from, or -1 on error
+  */
+ static int start_baseline(counter_t warmup) {
+     int fds[2];
+     if (pipe(fds) != 0) {
+         perror("Unable to create pipe");
+         return -1;
+     }
+     pid_t pid = fork();
+     if (pid < 0) {
+         perror("Unable to fork");
+         return -1;
+     }
+     if (pid > 0) {
+         close(fds[1]);
+         return fds[0];
+     }
+     // The child reads through its own file descriptions, so the parent's offsets stay put
+     close(fds[0]);
+     for (int i = 0; i < num_streams; i++) {
+         stream_traces[i] = open_trace(stream_names[i]);
+     }
+     // Plain fill path, and no output: the parent writes the trace, DRAM report and series
+     partition_kind = PARTITION_NONE;
+     deadblock_kind = DEADBLOCK_NONE;
+     misstrace_enabled = 0;
+     dram_enabled = 0;
+     timeseries_enabled = 0;
+     counter_t run_lines = 0;
+     while (next_mixed()) {
+         if (++run_lines == warmup) {
+             cachesim_reset_stats();
+         }
+     }
+     int ok = write(fds[1], stream_stats, sizeof(stream_stats)) == (ssize_t) sizeof(stream_stats);
+     _exit(ok ? 0 : 1);
+ }
+
  /**
   * Main function. See error message for usage. 
   * 
@@ -239,22 +1326,530 @@
   * @param argv Argument values
   * @returns 0 on success. 
   */
+ static struct option long_options[] = {
+     {"index", required_argument, 0, 'x'},
+     {"zcache-levels", required_argument, 0, 'z'},
+     {"waypred", required_argument, 0, 'w'},
+     {"warmup", required_argument, 0, 'u'},
+     {"checkpoint", required_argument, 0, 'c'},
+     {"checkpoint-at", required_argument, 0, 'a'},
+     {"restore", required_argument, 0, 'r'},
+     {"sample-interval", required_argument, 0, 'i'},
+     {"sample-period", required_argument, 0, 'p'},
+     {"sample-file", required_argument, 0, 'f'},
+     {"no-filter", no_argument, 0, 'n'},
+     {"filter-stats", no_argument, 0, 's'},
+     {"mrc", required_argument, 0, 'm'},
+     {"mrc-rate", required_argument, 0, 'R'},
+     {"mrc-samples", required_argument, 0, 'S'},
+     {"policy", required_argument, 0, 'P'},
+     {"hash-ways", required_argument, 0, 'H'},
+     {"miss-trace", required_argument, 0, 'M'},
+     {"addr-bits", required_argument, 0, 'A'},
+     {"state-stats", no_argument, 0, 'T'},
+     {"page-map", required_argument, 0, 'V'},
+     {"page-size", required_argument, 0, 'g'},
+     {"phys-mem", required_argument, 0, 'y'},
+     {"mix", required_argument, 0, 'X'},
+     {"partition", required_argument, 0, 'W'},
+     {"ucp-interval", required_argument, 0, 'I'},
+     {"dram", required_argument, 0, 'D'},
+     {"timeseries", required_argument, 0, 'Y'},
+     {"timeseries-every", required_argument, 0, 'e'},
+     {"timeseries-unit", required_argument, 0, 'U'},
+     {"timeseries-format", required_argument, 0, 'F'},
+     {"nuca", required_argument, 0, 'N'},
+     {"dead-block", required_argument, 0, 'B'},
+     {"tlb", required_argument, 0, 'L'},
+     {0, 0, 0, 0}
+ };
+
+ /**
+  * Function to print the usage message.
+  *
+  * @param prog is the program name
+  */
+ static void usage(const char* prog) {
+     fprintf(stderr, "Usage:\n  %s <trace> <block size(bytes)>"
+                     " <cache size(bytes)> <ways> [options]\n"
+                     "Options:\n"
+                     "  --index=<fn>         set index function: bitslice (default), xor, prime, skew, mod\n"
+                     "  --zcache-levels=<n>  replacement walk depth for skew, 1-%d (default 2)\n"
+                     "  --waypred=<kind>     way predictor to model: none (default), mru, pc\n"
+                     "  --warmup=<n>         reset the statistics after the first n accesses of this run\n"
+                     "  --checkpoint=<file>  save the cache state to file at the end of the trace\n"
+                     "  --checkpoint-at=<n>  ...or once n trace lines have been consumed\n"
+                     "  --restore=<file>     start from a saved cache state and its trace offset\n"
+                     "  --sample-interval=<n>  simulate intervals of n accesses, extrapolating the stats\n"
+                     "  --sample-period=<k>  ...in detail every kth interval (default 10)\n"
+                     "  --sample-file=<file> ...in detail the intervals listed in file, with optional weights\n"
+                     "  --no-filter          send repeat accesses to the same block through the full lookup\n"
+                     "  --filter-stats       report how many accesses the repeat filter served\n"
+                     "  --mrc=<csv>          write an approximate LRU miss ratio curve (SHARDS) to csv\n"
+                     "  --mrc-rate=<r>       ...starting at sampling rate r (default 1, lowered as needed)\n"
+                     "  --mrc-samples=<n>    ...tracking at most n sampled blocks (default %d)\n"
+                     "  --policy=<name>      replacement policy: lru (default), srrip, ship\n"
+                     "  --hash-ways=<n>      hashed lookup and O(1) LRU from n ways or one set (default %d, 0 never)\n"
+                     "  --miss-trace=<file>  write the misses and writebacks of this cache as a trace to file\n"
+                     "  --addr-bits=<n>      simulate n-bit addresses, 16-64 (default 32)\n"
+                     "  --state-stats        report the tag width and how many sets were touched\n"
+                     "  --page-map=<policy>  take addresses as virtual, placing pages by: sequential, random, binhop, color\n"
+                     "  --page-size=<n>      ...in pages of n bytes (default %d)\n"
+                     "  --phys-mem=<n>       ...in n bytes of physical memory (default 4GB or the address space)\n"
+                     "  --mix=<trace>        share the cache with another trace, interleaved access by access\n"
+                     "  --partition=<p>      partition the ways among the traces: ucp, or ways per trace (e.g. 6,2)\n"
+                     "  --ucp-interval=<n>   ...repartitioning every n accesses for ucp (default %d)\n"
+                     "  --dram=<spec>        time the misses and writebacks in DRAM: default, or key=value,...\n"
+                     "                       (channels, ranks, banks, rows, row, map, page, queue, gap, t*; see dram.h)\n"
+                     "  --timeseries=<file>  write the statistics of every interval, split by access type, to file\n"
+                     "  --timeseries-every=<n>  ...in intervals of n (default %d)\n"
+                     "  --timeseries-unit=<u>   ...counting accesses (default) or instructions\n"
+                     "  --timeseries-format=<f> ...as csv (default) or binary\n"
+                     "  --nuca=<spec>        model the cache as banks on a mesh: static or dynamic, then key=value,...\n"
+                     "                       (rows, cols, hop, bank, core_row, core_col; see nuca.h)\n"
+                     "  --dead-block=<kind>  keep streaming fills from polluting the cache: bypass (per-PC\n"
+                     "                       dead-block predictor) or dip (LRU/BIP insertion set dueling)\n"
+                     "  --tlb=<spec>         translate every access through L1 and L2 TLBs: lru or srrip, then\n"
+                     "                       key=value,... (itlb, dtlb, stlb, page, huge, walk, ...; see tlb.h)\n",
+                     prog, ZCACHE_MAX_LEVELS, SHARDS_DEFAULT_SAMPLES, DEFAULT_HASH_WAYS, PAGEMAP_DEFAULT_PAGE_SIZE,
+                     UCP_DEFAULT_INTERVAL, TIMESERIES_DEFAULT_LENGTH);
+ }
+
  int main(int argc, char **argv) {
      FILE *input;
- 
-     if (argc != 5) {
-         fprintf(stderr, "Usage:\n  %s <trace> <block size(bytes)>"
-                         " <cache size(bytes)> <ways>\n", argv[0]);
+     int opt;
+     counter_t warmup = 0;               // Accesses before the statistics are reset
+     const char* checkpoint_path = NULL; // Where to save the cache state
+     counter_t checkpoint_at = 0;        // Trace line to save it at, 0 for end of trace
+     const char* restore_path = NULL;    // Cache state to start from
+     counter_t sample_interval = 0;      // Accesses per sampling interval, 0 for no sampling
+     counter_t sample_period = 10;       // Every kth interval is detailed
+     const char* sample_path = NULL;     // File of detailed intervals
+     const char* mrc_path = NULL;        // Where to write the miss ratio curve
+     double mrc_rate = 1.0;              // Initial MRC sampling rate
+     int mrc_samples = SHARDS_DEFAULT_SAMPLES;
+     const char* miss_trace_path = NULL; // Where to write the miss trace
+     int page_map = PAGEMAP_NONE;        // Page placement policy, PAGEMAP_NONE for physical addresses
+     long long page_size = PAGEMAP_DEFAULT_PAGE_SIZE;
+     long long phys_mem = 0;             // Physical memory for the page map, 0 for the default
+     const char* timeseries_path = NULL; // Where to write the interval statistics
+     counter_t timeseries_every = TIMESERIES_DEFAULT_LENGTH;
+     int timeseries_unit = 0;            // 1 to count instructions instead of accesses
+     int timeseries_format = TIMESERIES_CSV;
+
+     while ((opt = getopt_long(argc, argv, "", long_options, NULL)) != -1) {
+         switch (opt) {
+         case 'x':
+             index_fn = index_parse(optarg);
+             if (index_fn < 0) {
+                 fprintf(stderr, "Unknown index function: %s\n", optarg);
+                 return 1;
+             }
+             break;
+         case 'z':
+             zcache_levels = atoi(optarg);
+             if (zcache_levels < 1 || zcache_levels > ZCACHE_MAX_LEVELS) {
+                 fprintf(stderr, "zcache levels must be between 1 and %d\n", ZCACHE_MAX_LEVELS);
+                 return 1;
+             }
+             break;
+         case 'w':
+             waypred_kind = waypred_parse(optarg);
+             if (waypred_kind < 0) {
+                 fprintf(stderr, "Unknown way predictor: %s\n", optarg);
+                 return 1;
+             }
+             break;
+         case 'u':
+             warmup = strtoull(optarg, NULL, 0);
+             break;
+         case 'c':
+             checkpoint_path = optarg;
+             break;
+         case 'a':
+             checkpoint_at = strtoull(optarg, NULL, 0);
+             break;
+         case 'r':
+             restore_path = optarg;
+             break;
+         case 'i':
+             sample_interval = strtoull(optarg, NULL, 0);
+             break;
+         case 'p':
+             sample_period = strtoull(optarg, NULL, 0);
+             break;
+         case 'f':
+             sample_path = optarg;
+             break;
+         case 'n':
+             filter_enabled = 0;
+             break;
+         case 's':
+             filter_stats = 1;
+             break;
+         case 'm':
+             mrc_path = optarg;
+             break;
+         case 'R':
+             mrc_rate = atof(optarg);
+             break;
+         case 'S':
+             mrc_samples = atoi(optarg);
+             break;
+         case 'P':
+             policy_kind = policy_parse(optarg);
+             if (policy_kind < 0) {
+                 fprintf(stderr, "Unknown replacement policy: %s\n", optarg);
+                 return 1;
+             }
+             break;
+         case 'H':
+             hash_ways = atoi(optarg);
+             break;
+         case 'M':
+             miss_trace_path = optarg;
+             break;
+         case 'A':
+             addr_bits = atoi(optarg);
+             if (addr_bits < 16 || addr_bits > 64) {
+                 fprintf(stderr, "Address bits must be between 16 and 64\n");
+                 return 1;
+             }
+             break;
+         case 'T':
+             state_stats = 1;
+             break;
+         case 'V':
+             page_map = pagemap_parse(optarg);
+             if (page_map <= PAGEMAP_NONE) {
+                 fprintf(stderr, "Unknown page placement policy: %s\n", optarg);
+                 return 1;
+             }
+             break;
+         case 'g':
+             page_size = atoll(optarg);
+             if (page_size < 1 || (page_size & (page_size - 1)) != 0) {
+                 fprintf(stderr, "--page-size must be a power of 2\n");
+                 return 1;
+             }
+             break;
+         case 'y':
+             phys_mem = atoll(optarg);
+             break;
+         case 'X':
+             if (num_streams == PARTITION_MAX_STREAMS) {
+                 fprintf(stderr, "At most %d traces can share the cache\n", PARTITION_MAX_STREAMS);
+                 return 1;
+             }
+             stream_names[num_streams++] = optarg;
+             break;
+         case 'W':
+             partition_kind = partition_parse(optarg);
+             if (partition_kind < 0) {
+                 fprintf(stderr, "Expected --partition=ucp or a list of ways, got %s\n", optarg);
+                 return 1;
+             }
+             break;
+         case 'D':
+             if (dram_parse(optarg) != 0) {
+                 return 1;
+             }
+             dram_enabled = 1;
+             break;
+         case 'Y':
+             timeseries_path = optarg;
+             break;
+         case 'e':
+             timeseries_every = strtoull(optarg, NULL, 0);
+             if (timeseries_every == 0) {
+                 fprintf(stderr, "--timeseries-every must be at least 1\n");
+                 return 1;
+             }
+             break;
+         case 'U':
+             timeseries_unit = timeseries_parse_unit(optarg);
+             if (timeseries_unit < 0) {
+                 fprintf(stderr, "Expected --timeseries-unit=accesses or instructions, got %s\n", optarg);
+                 return 1;
+             }
+             break;
+         case 'F':
+             timeseries_format = timeseries_parse_format(optarg);
+             if (timeseries_format < 0) {
+                 fprintf(stderr, "Expected --timeseries-format=csv or binary, got %s\n", optarg);
+                 return 1;
+             }
+             break;
+         case 'N':
+             if (nuca_parse(optarg) != 0) {
+                 return 1;
+             }
+             break;
+         case 'L':
+             if (tlb_parse(optarg) != 0) {
+                 return 1;
+             }
+             break;
+         case 'B':
+             deadblock_kind = deadblock_parse(optarg);
+             if (deadblock_kind <= DEADBLOCK_NONE) {
+                 fprintf(stderr, "Expected --dead-block=bypass or dip, got %s\n", optarg);
+                 return 1;
+             }
+             break;
+         case 'I':
+             ucp_interval = strtoull(optarg, NULL, 0);
+             if (ucp_interval == 0) {
+                 fprintf(stderr, "--ucp-interval must be at least 1\n");
+                 return 1;
+             }
+             break;
+         default:
+             usage(argv[0]);
+             return 1;
+         }
+     }
+     if (waypred_kind != WAYPRED_NONE && index_fn == INDEX_SKEW) {
+         fprintf(stderr, "Way prediction needs a set-associative index function\n");
+         return 1;
+     }
+     if (policy_kind != POLICY_LRU && index_fn == INDEX_SKEW) {
+         fprintf(stderr, "--policy=%s needs a set-associative index function\n", policy_name(policy_kind));
+         return 1;
+     }
+     waypred_init(waypred_kind);
+     if (sample_interval) {
+         if (warmup) {
+             fprintf(stderr, "Sampling already warms the cache between intervals, drop --warmup\n");
+             return 1;
+         }
+         if (sampling_init(sample_interval, sample_period, sample_path) != 0) {
+             return 1;
+         }
+         sampling_active = 1;
+     }
+     if (mrc_path) {
+         if (shards_init(mrc_rate, mrc_samples) != 0) {
+             return 1;
+         }
+         mrc_enabled = 1;
+     }
+     if (miss_trace_path) {
+         if (sample_interval) {
+             fprintf(stderr, "The miss trace needs every access simulated, drop --sample-interval\n");
+             return 1;
+         }
+         if (misstrace_open(miss_trace_path) != 0) {
+             return 1;
+         }
+         misstrace_enabled = 1;
+     }
+     if (dram_enabled && (sample_interval || checkpoint_path || restore_path)) {
+         fprintf(stderr, "--dram needs every access simulated and no checkpoints\n");
+         return 1;
+     }
+     if (timeseries_path) {
+         if (sample_interval || checkpoint_path || restore_path) {
+             fprintf(stderr, "The time series needs every access simulated and no checkpoints\n");
+             return 1;
+         }
+         if (timeseries_open(timeseries_path, timeseries_format, timeseries_every, timeseries_unit) != 0) {
+             return 1;
+         }
+         timeseries_enabled = 1;
+     }
+     if (num_streams > 1 && (checkpoint_path || restore_path || sample_interval || miss_trace_path)) {
+         fprintf(stderr, "--mix supports neither checkpoints, sampling nor the miss trace\n");
+         return 1;
+     }
+     if (partition_kind != PARTITION_NONE && (policy_kind != POLICY_LRU || index_fn == INDEX_SKEW)) {
+         fprintf(stderr, "Partitioning needs LRU and a set-associative index function\n");
+         return 1;
+     }
+     if (nuca_kind != NUCA_NONE) {
+         if (index_fn == INDEX_SKEW || sample_interval || checkpoint_path || restore_path) {
+             fprintf(stderr, "--nuca needs a set-associative index function, every access simulated"
+                             " and no checkpoints\n");
+             return 1;
+         }
+         if (nuca_kind == NUCA_DYNAMIC && (policy_kind != POLICY_LRU || partition_kind != PARTITION_NONE)) {
+             fprintf(stderr, "--nuca=dynamic needs LRU and no partitioning\n");
+             return 1;
+         }
+         // Every hit is charged to its bank, so none may skip the lookup
+         filter_enabled = 0;
+     }
+     if (tlb_enabled && (sample_interval || checkpoint_path || restore_path)) {
+         fprintf(stderr, "--tlb needs every access simulated and no checkpoints\n");
+         return 1;
+     }
+     if (deadblock_kind != DEADBLOCK_NONE
+         && (policy_kind != POLICY_LRU || index_fn == INDEX_SKEW || partition_kind != PARTITION_NONE
+             || nuca_kind == NUCA_DYNAMIC || sample_interval || checkpoint_path || restore_path)) {
+         fprintf(stderr, "--dead-block needs LRU, a set-associative index function, every access simulated,"
+                         " and no partitioning, D-NUCA or checkpoints\n");
+         return 1;
+     }
+     if (page_map != PAGEMAP_NONE && (checkpoint_path || restore_path)) {
+         fprintf(stderr, "The page map is not part of a checkpoint, drop --page-map\n");
+         return 1;
+     }
+
+     if (argc - optind != 4) {
+         usage(argv[0]);
+         return 1;
+     }
+     argv += optind - 1;
+     if (cachesim_check_geometry(atoll(argv[2]), atoll(argv[3]), atoll(argv[4])) != 0) {
          return 1;
      }
      
      input = open_trace(argv[1]);
-     cachesim_init(atol(argv[2]), atol(argv[3]), atol(argv[4]));
-     while (next_line(input));
+     if (!input) {
+         perror("Unable to open trace file");
+         return 1;
+     }
+     stream_names[0] = argv[1];
+     stream_traces[0] = input;
+     for (int i = 1; i < num_streams; i++) {
+         stream_traces[i] = open_trace(stream_names[i]);
+         if (!stream_traces[i]) {
+             perror("Unable to open trace file");
+             return 1;
+         }
+     }
+
+     counter_t run_lines = 0;
+     if (restore_path) {
+         long long trace_pos;
+         if (cachesim_restore(restore_path, atol(argv[2]), atoll(argv[3]), atol(argv[4]),
+                              &trace_lines, &trace_pos) != 0) {
+             return 1;
+         }
+         if (fseek(input, trace_pos, SEEK_SET) != 0) {
+             perror("Unable to seek to the checkpoint's trace offset");
+             return 1;
+         }
+     } else {
+         partition_streams = num_streams;    // Sizes the arena's stream section
+         cachesim_init(atol(argv[2]), atoll(argv[3]), atol(argv[4]));
+     }
+     if (page_map != PAGEMAP_NONE) {
+         // Default to 4GB of physical memory, or all of it for narrower addresses
+         unsigned long long space = (addr_bits < 64) ? 1ULL << addr_bits : ~0ULL;
+         if (phys_mem == 0) {
+             phys_mem = (space < (4ULL << 30)) ? (long long) space : 4LL << 30;
+         }
+         if (page_size < block_size || phys_mem < page_size || phys_mem % page_size != 0
+             || (unsigned long long) phys_mem > space) {
+             fprintf(stderr, "Pages must hold whole blocks and physical memory must be whole pages"
+                             " within the address space\n");
+             return 1;
+         }
+         // A color is a page-sized slice of one way
+         long long colors = (long long) num_sets * block_size / page_size;
+         if (pagemap_init(page_map, page_size, phys_mem, colors > 0 ? colors : 1) != 0) {
+             return 1;
+         }
+     }
+     if (partition_init(num_streams, ways, num_sets) != 0) {
+         return 1;
+     }
+     if (nuca_kind == NUCA_DYNAMIC && hashed) {
+         fprintf(stderr, "--nuca=dynamic needs the scanned lookup, use --hash-ways=0\n");
+         return 1;
+     }
+     if (nuca_kind != NUCA_NONE && nuca_init(ways) != 0) {
+         return 1;
+     }
+     if (deadblock_kind != DEADBLOCK_NONE) {
+         if (hashed) {
+             fprintf(stderr, "--dead-block needs the scanned lookup, use --hash-ways=0\n");
+             return 1;
+         }
+         deadblock_init(num_sets);
+     }
+     if (tlb_enabled && tlb_init(addr_bits) != 0) {
+         return 1;
+     }
+     if (dram_enabled && dram_init(block_size) != 0) {
+         return 1;
+     }
+     int baseline_fd = -1;
+     if ((partition_kind != PARTITION_NONE || deadblock_kind != DEADBLOCK_NONE)
+         && (baseline_fd = start_baseline(warmup)) < 0) {
+         return 1;
+     }
+
+     // Counters at the start of the current sampling interval
+     counter_t interval = 0;
+     counter_t start_accesses = accesses, start_misses = misses, start_writebacks = writebacks;
+     if (sample_interval) {
+         detailed = sampling_is_detailed(0);
+     }
+
+     while ((num_streams > 1) ? next_mixed() : next_line(input)) {
+         trace_lines++;
+         run_lines++;
+         if (run_lines == warmup) {
+             cachesim_reset_stats();
+         }
+         if (sample_interval && run_lines % sample_interval == 0) {
+             if (detailed) {
+                 sampling_record(interval, accesses - start_accesses, misses - start_misses,
+                                 writebacks - start_writebacks);
+             }
+             interval++;
+             detailed = sampling_is_detailed(interval);
+             start_accesses = accesses;
+             start_misses = misses;
+             start_writebacks = writebacks;
+         }
+         if (checkpoint_path && trace_lines == checkpoint_at) {
+             if (cachesim_checkpoint(checkpoint_path, trace_lines, ftell(input)) != 0) {
+                 return 1;
+             }
+         }
+     }
+     if (checkpoint_path && checkpoint_at == 0) {
+         if (cachesim_checkpoint(checkpoint_path, trace_lines, ftell(input)) != 0) {
+             return 1;
+         }
+     }
+     if (mrc_path && shards_write_mrc(mrc_path, block_size) != 0) {
+         return 1;
+     }
+     if (misstrace_close() != 0 || timeseries_close() != 0) {
+         return 1;
+     }
+     if (dram_enabled) {
+         dram_finish();
+     }
+     if (baseline_fd >= 0) {
+         int status;
+         if (read(baseline_fd, stream_baseline, sizeof(stream_baseline)) != (ssize_t) sizeof(stream_baseline)
+             || wait(&status) < 0 || status != 0) {
+             fprintf(stderr, "The unpartitioned run did not finish\n");
+             return 1;
+         }
+         close(baseline_fd);
+     }
+     if (sample_interval) {
+         // Count the trailing partial interval, then replace the counters with estimates
+         if (detailed) {
+             sampling_record(interval, accesses - start_accesses, misses - start_misses,
+                             writebacks - start_writebacks);
+         }
+         accesses = run_lines;
+         if (sampling_estimate(run_lines, &hits, &misses, &writebacks) != 0) {
+             return 1;
+         }
+     }
      cachesim_print_stats();
+     cachesim_print_report();
      cachesim_cleanup();
      fclose(input);
      return 0;
  }
- 
- 
\ No newline at end of file
+
+ #endif
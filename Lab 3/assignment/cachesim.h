@@ -17,28 +17,95 @@ typedef unsigned long long addr_t;		// Data type to hold addresses
 typedef unsigned long long counter_t;	// Data type to hold cache statistic variables
 
 /**
- * Struct for a cache block. Feel free to change any of this if you want. 
+ * Struct for a cache block. Feel free to change any of this if you want. The tag is
+ * kept in the packed tag array (see tagstore.h) and the time of last use of a skewed
+ * cache in an array of its own, so a block is only the state every cache needs.
  */
 typedef struct cache_block_t {
-	int tag;
-	int valid;
-	int dirty;
+	unsigned char valid;
+	unsigned char dirty;
+	unsigned char rrpv;		// Re-reference prediction value, RRIP policies only
+	unsigned char flags;	// BLOCK_* bits, SHiP and dead-block bypass only
+	unsigned short signature;	// SHCT or dead-block predictor entry of the instruction that filled it
 } cache_block_t;
 
 /**
- * Struct for a cache set. Feel free to change any of this if you want. 
+ * Struct for a cache set. Sets are not allocated on their own: a set is a view into
+ * the cache state arena, built when the set is accessed.
  */
 typedef struct cache_set_t {
 	int size;				// Number of blocks in this cache set
-	lru_stack_t* stack;		// LRU Stack 
-	cache_block_t* blocks;	// Array of cache block structs. You will need to
-							// 	dynamically allocate based on number of blocks
-							//	per set. 
+	int index;				// Set number
+	int* mru;				// Most recently used way, probed first on a lookup
+	lru_stack_t stack;		// LRU Stack over this set's ranks in the arena
+	cache_block_t* blocks;	// This set's blocks in the arena
 } cache_set_t;
 
-void cachesim_init(int block_size, int cache_size, int ways);
+/**
+ * Header of the cache state arena. The whole cache (this header, every block and all
+ * of the replacement state) is one contiguous allocation that refers to its sections
+ * by offset, so a checkpoint is the arena written out and a restore maps it back in.
+ */
+typedef struct cache_state_t {
+	char magic[8];			// CACHE_STATE_MAGIC
+	int version;			// CACHE_STATE_VERSION
+	int block_size;			// Geometry and index function the state was built with
+	long long cache_size;
+	int ways;
+	int num_sets;
+	int index_fn;
+	int policy;				// Replacement policy, POLICY_*
+	int waypred;			// Way predictor, WAYPRED_*
+	int hashed;				// 1 for the hashed lookup and LRU lists, see fullassoc.h
+	int hash_bits;			// log2 of the hash slots when hashed
+	int addr_bits;			// Address bits simulated
+	int tag_bytes;			// Width of each tag in the tag array
+	counter_t accesses;		// Statistics when the checkpoint was taken
+	counter_t hits;
+	counter_t misses;
+	counter_t writebacks;
+	counter_t relocations;
+	counter_t clock_stamp;
+	counter_t waypred_first;	// Way predictor and SHiP statistics, see waypred.h and policy.h
+	counter_t waypred_second;
+	counter_t waypred_missed;
+	counter_t ship_fills;
+	counter_t ship_dead_fills;
+	counter_t ship_dead_correct;
+	counter_t ship_dead_wrong;
+	counter_t ship_live_correct;
+	counter_t ship_live_wrong;
+	counter_t trace_lines;	// Trace lines consumed when the checkpoint was taken
+	long long trace_pos;	// Byte offset of the next trace line
+	unsigned long long size;			// Bytes in the whole arena
+	unsigned long long lines_offset;	// cache_block_t[num_sets * ways]
+	unsigned long long tags_offset;		// tag_bytes * num_sets * ways, packed tags
+	unsigned long long stamps_offset;	// counter_t[num_sets * ways], time of last use, skew only
+	unsigned long long ready_offset;	// unsigned long long[(num_sets + 63) / 64], sets set up so far
+	unsigned long long ranks_offset;	// int[num_sets * ways], LRU ranks, unless hashed
+	unsigned long long mru_offset;		// int[num_sets], MRU way of each set
+	unsigned long long shct_offset;		// unsigned char[SHIP_SHCT_ENTRIES], SHiP only
+	unsigned long long links_offset;	// fa_link_t[num_sets * ways], hashed only
+	unsigned long long lists_offset;	// fa_list_t[num_sets], hashed only
+	unsigned long long slots_offset;	// unsigned[1 << hash_bits], hashed only
+	unsigned long long streams_offset;	// unsigned char[num_sets * ways], stream that filled each block, --mix only
+	unsigned long long pc_table_offset;	// int[WAYPRED_PC_ENTRIES], way last used by each PC hash, --waypred=pc only
+} cache_state_t;
+
+#define CACHE_STATE_MAGIC "CSIMSTAT"
+#define CACHE_STATE_VERSION 7
+
+void cachesim_init(int block_size, long long cache_size, int ways);
 void cachesim_access(addr_t physical_add, int access_type);
+void cachesim_access_pc(addr_t physical_add, int access_type, addr_t pc);
+void cachesim_warm(addr_t physical_add, int access_type, addr_t pc);
 void cachesim_cleanup(void);
+void cachesim_reset_stats(void);
+int cachesim_checkpoint(const char* path, counter_t trace_lines, long long trace_pos);
+int cachesim_restore(const char* path, int block_size, long long cache_size, int ways,
+					 counter_t* trace_lines, long long* trace_pos);
 void cachesim_print_stats(void);
+void cachesim_print_report(void);
+int cachesim_check_geometry(long long block_size, long long cache_size, long long ways);
 
 #endif
@@ -0,0 +1,169 @@
+/**
+ * @author ECE 3058 TAs
+ */
+
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <errno.h>
+ #include <unistd.h>
+ #include <sys/socket.h>
+ #include <sys/un.h>
+ #include "cachesimd.h"
+
+ /**
+  * Function to read exactly <n> bytes from <fd>, retrying short reads.
+  *
+  * @return 0 on success, -1 on error or end of file
+  */
+ int cachesimd_read_full(int fd, void* buf, size_t n) {
+     char* p = (char*) buf;
+     while (n > 0) {
+         ssize_t r = read(fd, p, n);
+         if (r < 0 && errno == EINTR) {
+             continue;
+         }
+         if (r <= 0) {
+             return -1;
+         }
+         p += r;
+         n -= (size_t) r;
+     }
+     return 0;
+ }
+
+ /**
+  * Function to write exactly <n> bytes to <fd>, retrying short writes.
+  *
+  * @return 0 on success, -1 on error
+  */
+ int cachesimd_write_full(int fd, const void* buf, size_t n) {
+     const char* p = (const char*) buf;
+     while (n > 0) {
+         ssize_t w = write(fd, p, n);
+         if (w < 0 && errno == EINTR) {
+             continue;
+         }
+         if (w <= 0) {
+             return -1;
+         }
+         p += w;
+         n -= (size_t) w;
+     }
+     return 0;
+ }
+
+ /**
+  * Function to connect to the daemon listening on <path>.
+  *
+  * @param path is the daemon's socket
+  * @return the connection, or NULL on error
+  */
+ cachesimd_client_t* cachesimd_open(const char* path) {
+     struct sockaddr_un addr;
+     if (strlen(path) >= sizeof(addr.sun_path)) {
+         fprintf(stderr, "Socket path too long: %s\n", path);
+         return NULL;
+     }
+     int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+     if (fd < 0) {
+         perror("Unable to create socket");
+         return NULL;
+     }
+     memset(&addr, 0, sizeof(addr));
+     addr.sun_family = AF_UNIX;
+     strcpy(addr.sun_path, path);
+     if (connect(fd, (struct sockaddr*) &addr, sizeof(addr)) != 0) {
+         perror("Unable to connect to cachesimd");
+         close(fd);
+         return NULL;
+     }
+     cachesimd_client_t* c = (cachesimd_client_t*) malloc(sizeof(cachesimd_client_t));
+     c->fd = fd;
+     c->pending = 0;
+     return c;
+ }
+
+ /**
+  * Function to send the queued accesses.
+  *
+  * @return 0 on success, -1 on error
+  */
+ int cachesimd_flush(cachesimd_client_t* c) {
+     if (c->pending == 0) {
+         return 0;
+     }
+     cachesimd_msg_t msg = { CACHESIMD_MSG_ACCESS, c->pending };
+     c->pending = 0;
+     if (cachesimd_write_full(c->fd, &msg, sizeof(msg)) != 0
+         || cachesimd_write_full(c->fd, c->batch, sizeof(cachesimd_record_t) * msg.count) != 0) {
+         perror("Unable to send accesses to cachesimd");
+         return -1;
+     }
+     return 0;
+ }
+
+ /**
+  * Function to send the query <type> and read the statistics it is answered with.
+  *
+  * @return the number of caches, or -1 on error
+  */
+ static int query(cachesimd_client_t* c, uint32_t type, cachesimd_stats_t* stats, int max) {
+     cachesimd_msg_t msg = { type, 0 };
+     if (cachesimd_flush(c) != 0 || cachesimd_write_full(c->fd, &msg, sizeof(msg)) != 0
+         || cachesimd_read_full(c->fd, &msg, sizeof(msg)) != 0 || msg.type != CACHESIMD_MSG_STATS) {
+         fprintf(stderr, "cachesimd did not answer the query\n");
+         return -1;
+     }
+     for (uint32_t i = 0; i < msg.count; i++) {
+         cachesimd_stats_t s;
+         if (cachesimd_read_full(c->fd, &s, sizeof(s)) != 0) {
+             fprintf(stderr, "cachesimd did not answer the query\n");
+             return -1;
+         }
+         if ((int) i < max) {
+             stats[i] = s;
+         }
+     }
+     return (int) msg.count;
+ }
+
+ /**
+  * Function to get a statistics snapshot of every cache. Queued accesses are sent
+  * first, so the snapshot includes them.
+  *
+  * @param stats is filled with one entry per cache
+  * @param max is the number of entries <stats> has room for
+  * @return the number of caches, or -1 on error
+  */
+ int cachesimd_stats(cachesimd_client_t* c, cachesimd_stats_t* stats, int max) {
+     return query(c, CACHESIMD_MSG_STATS, stats, max);
+ }
+
+ /**
+  * Function to reset the statistics of every cache, getting the snapshot from just
+  * before the reset. The caches stay warm.
+  *
+  * @return the number of caches, or -1 on error
+  */
+ int cachesimd_reset(cachesimd_client_t* c, cachesimd_stats_t* stats, int max) {
+     return query(c, CACHESIMD_MSG_RESET, stats, max);
+ }
+
+ /**
+  * Function to stop the daemon, getting the final snapshot.
+  *
+  * @return the number of caches, or -1 on error
+  */
+ int cachesimd_shutdown(cachesimd_client_t* c, cachesimd_stats_t* stats, int max) {
+     return query(c, CACHESIMD_MSG_SHUTDOWN, stats, max);
+ }
+
+ /**
+  * Function to send any queued accesses and close the connection.
+  */
+ void cachesimd_close(cachesimd_client_t* c) {
+     cachesimd_flush(c);
+     close(c->fd);
+     free(c);
+ }
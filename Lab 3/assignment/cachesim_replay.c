@@ -0,0 +1,119 @@
+/**
+ * @author ECE 3058 TAs
+ */
+
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <getopt.h>
+ #include "cachesimd.h"
+
+ /**
+  * Replays a trace into a running cachesimd and prints the statistics of every cache
+  * it keeps, one line per cache in the same format as cachesim. With --every the
+  * statistics are also printed every n accesses, as interval statistics when --reset
+  * is given. Build it with:
+  *   gcc -O2 -o cachesim_replay cachesim_replay.c cachesim_client.c
+  */
+
+ /**
+  * Function to print the statistics lines of the <n> caches in <stats>.
+  *
+  * @param label is printed before every line, or NULL for the plain stats line
+  */
+ static void print_stats(const char* label, cachesimd_stats_t* stats, int n) {
+     for (int i = 0; i < n; i++) {
+         if (label) {
+             printf("%s cache %d (%d %lld %d): ", label, i, stats[i].block_size,
+                    (long long) stats[i].cache_size, stats[i].ways);
+         }
+         printf("%llu, %llu, %llu, %llu\n", (unsigned long long) stats[i].accesses,
+                (unsigned long long) stats[i].hits, (unsigned long long) stats[i].misses,
+                (unsigned long long) stats[i].writebacks);
+     }
+ }
+
+ static struct option long_options[] = {
+     {"every", required_argument, 0, 'e'},
+     {"reset", no_argument, 0, 'r'},
+     {"shutdown", no_argument, 0, 's'},
+     {0, 0, 0, 0}
+ };
+
+ /**
+  * Main function. See error message for usage.
+  *
+  * @param argc number of arguments
+  * @param argv Argument values
+  * @returns 0 on success.
+  */
+ int main(int argc, char** argv) {
+     int opt;
+     unsigned long long every = 0;       // Accesses between intermediate queries, 0 for none
+     int reset = 0;                      // 1 to reset the statistics at every query
+     int shutdown = 0;                   // 1 to stop the daemon at the end of the trace
+     while ((opt = getopt_long(argc, argv, "", long_options, NULL)) != -1) {
+         switch (opt) {
+         case 'e':
+             every = strtoull(optarg, NULL, 10);
+             break;
+         case 'r':
+             reset = 1;
+             break;
+         case 's':
+             shutdown = 1;
+             break;
+         default:
+             optind = argc + 1;
+             break;
+         }
+     }
+     if (argc - optind != 2) {
+         fprintf(stderr, "Usage:\n  %s <socket> <trace> [--every=<n>] [--reset] [--shutdown]\n", argv[0]);
+         return 1;
+     }
+     FILE* trace = fopen(argv[optind + 1], "r");
+     if (!trace) {
+         perror("Unable to open trace file");
+         return 1;
+     }
+     cachesimd_client_t* c = cachesimd_open(argv[optind]);
+     if (!c) {
+         return 1;
+     }
+
+     cachesimd_stats_t stats[CACHESIMD_MAX_CACHES];
+     char line[256];
+     unsigned long long n = 0;
+     int caches;
+     while (fgets(line, sizeof(line), trace)) {
+         int t;
+         unsigned long long address, instr;
+         if (sscanf(line, "%d %llx %llx", &t, &address, &instr) != 3) {
+             continue;
+         }
+         if (cachesimd_access(c, address, (uint32_t) t, instr) != 0) {
+             return 1;
+         }
+         n++;
+         if (every && n % every == 0) {
+             caches = reset ? cachesimd_reset(c, stats, CACHESIMD_MAX_CACHES)
+                            : cachesimd_stats(c, stats, CACHESIMD_MAX_CACHES);
+             if (caches < 0) {
+                 return 1;
+             }
+             char label[32];
+             snprintf(label, sizeof(label), "@%llu", n);
+             print_stats(label, stats, caches < CACHESIMD_MAX_CACHES ? caches : CACHESIMD_MAX_CACHES);
+         }
+     }
+     fclose(trace);
+
+     caches = shutdown ? cachesimd_shutdown(c, stats, CACHESIMD_MAX_CACHES)
+                       : cachesimd_stats(c, stats, CACHESIMD_MAX_CACHES);
+     if (caches < 0) {
+         return 1;
+     }
+     print_stats(NULL, stats, caches < CACHESIMD_MAX_CACHES ? caches : CACHESIMD_MAX_CACHES);
+     cachesimd_close(c);
+     return 0;
+ }
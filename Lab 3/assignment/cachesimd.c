@@ -0,0 +1,424 @@
+/**
+ * @author ECE 3058 TAs
+ */
+
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <errno.h>
+ #include <signal.h>
+ #include <getopt.h>
+ #include <poll.h>
+ #include <unistd.h>
+ #include <sys/socket.h>
+ #include <sys/un.h>
+ #include <sys/wait.h>
+ #include "cachesim.h"
+ #include "cachesimd.h"
+
+ /**
+  * The cache simulator service. See cachesimd.h for the protocol.
+  *
+  * The parent process owns the listening socket and the client connections. Each
+  * cache runs in a child process of its own, connected to the parent by a socketpair,
+  * because the simulator keeps one cache in its globals. Batches are forwarded to every
+  * child without waiting, so the children simulate in parallel with each other and with
+  * the parent reading the next batch. A query is queued behind the batches already
+  * forwarded, so its answer covers exactly the accesses sent before it. The parent
+  * polls the children along with the clients and keeps ingesting batches while the
+  * caches work their way to a query; each cache's answer is collected when it comes
+  * in, and the client gets its reply once every cache has answered.
+  *
+  * Build it with:
+  *   gcc -O2 -DCACHESIM_NO_MAIN -o cachesimd cachesimd.c cachesim_client.c cachesim.c \
+  *       lrustack.c setindex.c policy.c fullassoc.c misstrace.c waypred.c checkpoint.c \
+  *       sampling.c shards.c pagemap.c partition.c dram.c timeseries.c nuca.c deadblock.c tlb.c
+  */
+
+ // Statistics of the cache simulated by this process, see cachesim.c
+ extern counter_t accesses;
+ extern counter_t hits;
+ extern counter_t misses;
+ extern counter_t writebacks;
+
+ #define MAX_CLIENTS 64
+ #define MAX_QUERIES 64      // Queries waiting for the caches' answers
+
+ /**
+  * One cache and the child process simulating it.
+  */
+ typedef struct instance_t {
+     int block_size;
+     long long cache_size;
+     int ways;
+     pid_t pid;
+     int fd;                 // Parent's end of the socketpair
+ } instance_t;
+
+ /**
+  * A query sent to the caches, waiting for all of their answers.
+  */
+ typedef struct query_t {
+     int fd;                 // Client to answer, -1 if it has gone away
+     int answered;           // Caches that have answered
+     cachesimd_stats_t stats[CACHESIMD_MAX_CACHES];
+ } query_t;
+
+ static instance_t caches[CACHESIMD_MAX_CACHES];
+ static int num_caches = 0;
+ static cachesimd_record_t batch[CACHESIMD_MAX_BATCH];
+
+ // Queries in the order they were sent, numbered from 0. Every cache answers them in
+ // that order, so each only needs the number of the next one it owes an answer.
+ static query_t queries[MAX_QUERIES];
+ static unsigned long long query_head = 0;   // Oldest query not yet replied to
+ static unsigned long long query_tail = 0;   // Number of the next query
+ static unsigned long long next_answer[CACHESIMD_MAX_CACHES];
+
+ /**
+  * Function to fill in the statistics of the cache of this process.
+  */
+ static void snapshot(instance_t* c, cachesimd_stats_t* s) {
+     s->block_size = c->block_size;
+     s->cache_size = c->cache_size;
+     s->ways = c->ways;
+     s->accesses = accesses;
+     s->hits = hits;
+     s->misses = misses;
+     s->writebacks = writebacks;
+ }
+
+ /**
+  * Main loop of the child process simulating <c>. It serves the messages the parent
+  * forwards until the parent asks it to shut down or goes away.
+  *
+  * @param c is the cache to simulate
+  * @param fd is the child's end of the socketpair
+  */
+ static void serve_cache(instance_t* c, int fd) {
+     cachesimd_msg_t msg;
+     cachesimd_stats_t s;
+     cachesim_init(c->block_size, c->cache_size, c->ways);
+     while (cachesimd_read_full(fd, &msg, sizeof(msg)) == 0) {
+         switch (msg.type) {
+         case CACHESIMD_MSG_ACCESS:
+             if (cachesimd_read_full(fd, batch, sizeof(cachesimd_record_t) * msg.count) != 0) {
+                 return;
+             }
+             for (uint32_t i = 0; i < msg.count; i++) {
+                 cachesim_access_pc(batch[i].addr, (int) batch[i].type, batch[i].pc);
+             }
+             break;
+         case CACHESIMD_MSG_STATS:
+         case CACHESIMD_MSG_RESET:
+         case CACHESIMD_MSG_SHUTDOWN:
+             snapshot(c, &s);
+             if (cachesimd_write_full(fd, &s, sizeof(s)) != 0) {
+                 return;
+             }
+             if (msg.type == CACHESIMD_MSG_RESET) {
+                 cachesim_reset_stats();
+             } else if (msg.type == CACHESIMD_MSG_SHUTDOWN) {
+                 return;
+             }
+             break;
+         }
+     }
+ }
+
+ /**
+  * Function to start the child process of every cache.
+  *
+  * @return 0 on success, -1 on error
+  */
+ static int start_caches() {
+     for (int i = 0; i < num_caches; i++) {
+         int fds[2];
+         if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+             perror("Unable to create socketpair");
+             return -1;
+         }
+         pid_t pid = fork();
+         if (pid < 0) {
+             perror("Unable to fork");
+             return -1;
+         }
+         if (pid == 0) {
+             close(fds[0]);
+             for (int j = 0; j < i; j++) {
+                 close(caches[j].fd);
+             }
+             serve_cache(&caches[i], fds[1]);
+             cachesim_cleanup();
+             _exit(0);
+         }
+         close(fds[1]);
+         caches[i].pid = pid;
+         caches[i].fd = fds[0];
+     }
+     return 0;
+ }
+
+ /**
+  * Function to read the answer of cache <i> to the oldest query it owes one, and reply
+  * to every client whose query all caches have now answered. A client that has gone
+  * away is skipped; its connection is closed when the poll sees it hang up.
+  */
+ static void collect_answer(int i) {
+     if (next_answer[i] == query_tail) {
+         fprintf(stderr, "Lost the process of cache %d\n", i);   // Nothing asked, so it hung up
+         exit(1);
+     }
+     query_t* q = &queries[next_answer[i] % MAX_QUERIES];
+     if (cachesimd_read_full(caches[i].fd, &q->stats[i], sizeof(q->stats[i])) != 0) {
+         fprintf(stderr, "Lost the process of cache %d\n", i);
+         exit(1);
+     }
+     next_answer[i]++;
+     q->answered++;
+     while (query_head != query_tail && queries[query_head % MAX_QUERIES].answered == num_caches) {
+         q = &queries[query_head++ % MAX_QUERIES];
+         cachesimd_msg_t msg = { CACHESIMD_MSG_STATS, (uint32_t) num_caches };
+         if (q->fd >= 0 && cachesimd_write_full(q->fd, &msg, sizeof(msg)) == 0) {
+             cachesimd_write_full(q->fd, q->stats, sizeof(cachesimd_stats_t) * num_caches);
+         }
+     }
+ }
+
+ /**
+  * Function to wait for the caches to answer every query up to number <seq>.
+  */
+ static void wait_answers(unsigned long long seq) {
+     for (int i = 0; i < num_caches; i++) {
+         while (next_answer[i] < seq) {
+             collect_answer(i);
+         }
+     }
+ }
+
+ /**
+  * Function to forward the query <type> to every cache. The client on <fd> gets its
+  * reply once all of them have answered (see collect_answer). Only when MAX_QUERIES
+  * are already waiting does this wait for the oldest one.
+  */
+ static void send_query(int fd, uint32_t type) {
+     if (query_tail - query_head == MAX_QUERIES) {
+         wait_answers(query_head + 1);
+     }
+     query_t* q = &queries[query_tail++ % MAX_QUERIES];
+     q->fd = fd;
+     q->answered = 0;
+     cachesimd_msg_t msg = { type, 0 };
+     for (int i = 0; i < num_caches; i++) {
+         if (cachesimd_write_full(caches[i].fd, &msg, sizeof(msg)) != 0) {
+             fprintf(stderr, "Lost the process of cache %d\n", i);
+             exit(1);
+         }
+     }
+ }
+
+ /**
+  * Function to forget the client on <fd> in the queries still waiting, before its
+  * descriptor is closed and possibly reused by a new client.
+  */
+ static void forget_client(int fd) {
+     for (unsigned long long n = query_head; n != query_tail; n++) {
+         if (queries[n % MAX_QUERIES].fd == fd) {
+             queries[n % MAX_QUERIES].fd = -1;
+         }
+     }
+ }
+
+ /**
+  * Function to serve one message from the client on <fd>.
+  *
+  * @return 1 to keep the connection, 0 to close it, -1 to shut the daemon down
+  */
+ static int serve_client(int fd) {
+     cachesimd_msg_t msg;
+     if (cachesimd_read_full(fd, &msg, sizeof(msg)) != 0) {
+         return 0;
+     }
+     switch (msg.type) {
+     case CACHESIMD_MSG_ACCESS:
+         if (msg.count > CACHESIMD_MAX_BATCH) {
+             fprintf(stderr, "Dropping a client that sent a batch of %u accesses\n", msg.count);
+             return 0;
+         }
+         if (cachesimd_read_full(fd, batch, sizeof(cachesimd_record_t) * msg.count) != 0) {
+             return 0;
+         }
+         for (int i = 0; i < num_caches; i++) {
+             if (cachesimd_write_full(caches[i].fd, &msg, sizeof(msg)) != 0
+                 || cachesimd_write_full(caches[i].fd, batch, sizeof(cachesimd_record_t) * msg.count) != 0) {
+                 fprintf(stderr, "Lost the process of cache %d\n", i);
+                 exit(1);
+             }
+         }
+         return 1;
+     case CACHESIMD_MSG_STATS:
+     case CACHESIMD_MSG_RESET:
+         send_query(fd, msg.type);
+         return 1;
+     case CACHESIMD_MSG_SHUTDOWN:
+         // Answer everything still waiting, this query last, before stopping
+         send_query(fd, msg.type);
+         wait_answers(query_tail);
+         return -1;
+     default:
+         fprintf(stderr, "Dropping a client that sent message type %u\n", msg.type);
+         return 0;
+     }
+ }
+
+ /**
+  * Function to create the listening socket at <path>, replacing any stale one.
+  *
+  * @return the socket, or -1 on error
+  */
+ static int listen_on(const char* path) {
+     struct sockaddr_un addr;
+     if (strlen(path) >= sizeof(addr.sun_path)) {
+         fprintf(stderr, "Socket path too long: %s\n", path);
+         return -1;
+     }
+     int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+     if (fd < 0) {
+         perror("Unable to create socket");
+         return -1;
+     }
+     memset(&addr, 0, sizeof(addr));
+     addr.sun_family = AF_UNIX;
+     strcpy(addr.sun_path, path);
+     unlink(path);
+     if (bind(fd, (struct sockaddr*) &addr, sizeof(addr)) != 0 || listen(fd, 16) != 0) {
+         perror("Unable to listen on socket");
+         close(fd);
+         return -1;
+     }
+     return fd;
+ }
+
+ /**
+  * Function to parse --cache=<block size>:<cache size>:<ways> into the next instance.
+  *
+  * @return 0 on success, -1 on error
+  */
+ static int add_cache(const char* arg) {
+     long long b, s, w;
+     if (num_caches == CACHESIMD_MAX_CACHES) {
+         fprintf(stderr, "At most %d caches are supported\n", CACHESIMD_MAX_CACHES);
+         return -1;
+     }
+     if (sscanf(arg, "%lld:%lld:%lld", &b, &s, &w) != 3) {
+         fprintf(stderr, "Expected --cache=<block size>:<cache size>:<ways>, got %s\n", arg);
+         return -1;
+     }
+     if (cachesim_check_geometry(b, s, w) != 0) {
+         return -1;
+     }
+     caches[num_caches].block_size = (int) b;
+     caches[num_caches].cache_size = s;
+     caches[num_caches].ways = (int) w;
+     num_caches++;
+     return 0;
+ }
+
+ static struct option long_options[] = {
+     {"cache", required_argument, 0, 'c'},
+     {0, 0, 0, 0}
+ };
+
+ /**
+  * Main function. Serves clients until one of them sends SHUTDOWN.
+  *
+  * @param argc number of arguments
+  * @param argv Argument values
+  * @returns 0 on success.
+  */
+ int main(int argc, char** argv) {
+     int opt;
+     while ((opt = getopt_long(argc, argv, "", long_options, NULL)) != -1) {
+         if (opt != 'c' || add_cache(optarg) != 0) {
+             fprintf(stderr, "Usage:\n  %s <socket> --cache=<block size>:<cache size>:<ways> [--cache=...]\n", argv[0]);
+             return 1;
+         }
+     }
+     if (argc - optind != 1 || num_caches == 0) {
+         fprintf(stderr, "Usage:\n  %s <socket> --cache=<block size>:<cache size>:<ways> [--cache=...]\n", argv[0]);
+         return 1;
+     }
+     const char* path = argv[optind];
+
+     signal(SIGPIPE, SIG_IGN);
+     // Start the caches first, so their processes do not inherit the listening socket
+     if (start_caches() != 0) {
+         return 1;
+     }
+     int listen_fd = listen_on(path);
+     if (listen_fd < 0) {
+         return 1;
+     }
+
+     // Slot 0 is the listening socket, then one slot per cache, then the clients
+     struct pollfd fds[1 + CACHESIMD_MAX_CACHES + MAX_CLIENTS];
+     int first_client = 1 + num_caches;
+     int nfds = first_client;
+     fds[0].fd = listen_fd;
+     fds[0].events = POLLIN;
+     for (int i = 0; i < num_caches; i++) {
+         fds[1 + i].fd = caches[i].fd;
+         fds[1 + i].events = POLLIN;
+     }
+     int running = 1;
+     while (running) {
+         if (poll(fds, nfds, -1) < 0) {
+             if (errno == EINTR) {
+                 continue;
+             }
+             perror("poll");
+             break;
+         }
+         for (int i = 0; i < num_caches; i++) {
+             if (fds[1 + i].revents != 0) {
+                 collect_answer(i);
+             }
+         }
+         for (int i = nfds - 1; i >= first_client && running; i--) {
+             if (fds[i].revents == 0) {
+                 continue;
+             }
+             int r = serve_client(fds[i].fd);
+             if (r <= 0) {
+                 forget_client(fds[i].fd);
+                 close(fds[i].fd);
+                 fds[i] = fds[--nfds];
+             }
+             running = (r >= 0);
+         }
+         if (running && (fds[0].revents & POLLIN)) {
+             int fd = accept(listen_fd, NULL, NULL);
+             if (fd >= 0 && nfds == first_client + MAX_CLIENTS) {
+                 fprintf(stderr, "At most %d clients are supported\n", MAX_CLIENTS);
+                 close(fd);
+             } else if (fd >= 0) {
+                 fds[nfds].fd = fd;
+                 fds[nfds].events = POLLIN;
+                 fds[nfds].revents = 0;
+                 nfds++;
+             }
+         }
+     }
+
+     for (int i = first_client; i < nfds; i++) {
+         close(fds[i].fd);
+     }
+     close(listen_fd);
+     unlink(path);
+     // Closing the socketpairs stops any child that did not get the SHUTDOWN
+     for (int i = 0; i < num_caches; i++) {
+         close(caches[i].fd);
+         waitpid(caches[i].pid, NULL, 0);
+     }
+     return 0;
+ }
@@ -0,0 +1,158 @@
+/**
+ * @author ECE 3058 TAs
+ */
+
+#ifndef __CACHESIMD_H
+#define __CACHESIMD_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * This file contains the protocol of the cache simulator service (cachesimd) and the
+ * client library used to talk to it.
+ *
+ * cachesimd listens on a Unix domain socket and keeps one or more caches warm for as
+ * long as it runs. Every cache is its own process, since the simulator keeps its state
+ * in globals, and every batch of accesses is fanned out to all of them. Clients send
+ * batches of binary access records and may at any point ask for a statistics snapshot
+ * or reset. The daemon keeps reading batches from every client while the caches catch
+ * up to a query, and replies once each of them has answered, so a query does not stop
+ * ingestion.
+ *
+ * Every message starts with a cachesimd_msg_t. ACCESS is followed by <count> records
+ * and has no reply. STATS, RESET and SHUTDOWN have no payload and are answered with a
+ * STATS message followed by one cachesimd_stats_t per cache. RESET answers with the
+ * statistics from just before the reset, so a client can read interval statistics
+ * without losing accesses between the query and the reset.
+ *
+ * NOTES:
+ *      - Everything is in host byte order. Both ends are on the same machine.
+ *      - Build the daemon from cachesimd.c, cachesim_client.c and all of the simulator
+ *      sources with -DCACHESIM_NO_MAIN, and the replay tool from cachesim_replay.c and
+ *      cachesim_client.c.
+ */
+
+#define CACHESIMD_MSG_ACCESS 1
+#define CACHESIMD_MSG_STATS 2
+#define CACHESIMD_MSG_RESET 3
+#define CACHESIMD_MSG_SHUTDOWN 4
+
+#define CACHESIMD_MAX_BATCH 4096    // Most records in one ACCESS message
+#define CACHESIMD_MAX_CACHES 16     // Most caches one daemon keeps
+
+/**
+ * Header of every message.
+ */
+typedef struct cachesimd_msg_t {
+    uint32_t type;          // CACHESIMD_MSG_*
+    uint32_t count;         // Records or stats that follow
+} cachesimd_msg_t;
+
+/**
+ * One access, the binary form of a trace line.
+ */
+typedef struct cachesimd_record_t {
+    uint64_t addr;          // Address of the access
+    uint64_t pc;            // Address of the instruction making it
+    uint32_t type;          // MEMREAD, MEMWRITE or IFETCH
+    uint32_t reserved;
+} cachesimd_record_t;
+
+/**
+ * Statistics snapshot of one cache.
+ */
+typedef struct cachesimd_stats_t {
+    int32_t block_size;     // Geometry of the cache
+    int32_t ways;
+    int64_t cache_size;
+    uint64_t accesses;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t writebacks;
+} cachesimd_stats_t;
+
+/**
+ * Connection to cachesimd. Accesses are buffered and sent a batch at a time.
+ */
+typedef struct cachesimd_client_t {
+    int fd;
+    uint32_t pending;
+    cachesimd_record_t batch[CACHESIMD_MAX_BATCH];
+} cachesimd_client_t;
+
+/**
+ * Function to read exactly <n> bytes from <fd>, retrying short reads.
+ *
+ * @return 0 on success, -1 on error or end of file
+ */
+int cachesimd_read_full(int fd, void* buf, size_t n);
+
+/**
+ * Function to write exactly <n> bytes to <fd>, retrying short writes.
+ *
+ * @return 0 on success, -1 on error
+ */
+int cachesimd_write_full(int fd, const void* buf, size_t n);
+
+/**
+ * Function to connect to the daemon listening on <path>.
+ *
+ * @return the connection, or NULL on error
+ */
+cachesimd_client_t* cachesimd_open(const char* path);
+
+/**
+ * Function to queue one access, sending the batch once it is full.
+ *
+ * @return 0 on success, -1 on error
+ */
+static inline int cachesimd_access(cachesimd_client_t* c, uint64_t addr, uint32_t type, uint64_t pc);
+
+/**
+ * Function to send the queued accesses.
+ *
+ * @return 0 on success, -1 on error
+ */
+int cachesimd_flush(cachesimd_client_t* c);
+
+/**
+ * Function to get a statistics snapshot of every cache. Queued accesses are sent
+ * first, so the snapshot includes them.
+ *
+ * @param stats is filled with one entry per cache
+ * @param max is the number of entries <stats> has room for
+ * @return the number of caches, or -1 on error
+ */
+int cachesimd_stats(cachesimd_client_t* c, cachesimd_stats_t* stats, int max);
+
+/**
+ * Function to reset the statistics of every cache, getting the snapshot from just
+ * before the reset. The caches stay warm.
+ *
+ * @return the number of caches, or -1 on error
+ */
+int cachesimd_reset(cachesimd_client_t* c, cachesimd_stats_t* stats, int max);
+
+/**
+ * Function to stop the daemon, getting the final snapshot.
+ *
+ * @return the number of caches, or -1 on error
+ */
+int cachesimd_shutdown(cachesimd_client_t* c, cachesimd_stats_t* stats, int max);
+
+/**
+ * Function to send any queued accesses and close the connection.
+ */
+void cachesimd_close(cachesimd_client_t* c);
+
+static inline int cachesimd_access(cachesimd_client_t* c, uint64_t addr, uint32_t type, uint64_t pc) {
+    cachesimd_record_t* r = &c->batch[c->pending++];
+    r->addr = addr;
+    r->pc = pc;
+    r->type = type;
+    r->reserved = 0;
+    return (c->pending == CACHESIMD_MAX_BATCH) ? cachesimd_flush(c) : 0;
+}
+
+#endif
@@ -0,0 +1,114 @@
+/**
+ * @author ECE 3058 TAs
+ */
+
+ #include <stdio.h>
+ #include <fcntl.h>
+ #include <unistd.h>
+ #include <sys/mman.h>
+ #include <sys/stat.h>
+ #include "checkpoint.h"
+
+ /**
+  * Function to allocate an arena of <size> zero bytes. Pages take memory only once
+  * they are written.
+  *
+  * @param size is the size of the arena in bytes
+  * @return the start of the arena, or NULL on error
+  */
+ void* checkpoint_alloc(size_t size) {
+     void* data = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+     if (data == MAP_FAILED) {
+         perror("Unable to allocate cache state");
+         return NULL;
+     }
+     return data;
+ }
+
+ /**
+  * Function to check whether the <n> bytes at <p> are all zero.
+  */
+ static int all_zero(const unsigned char* p, size_t n) {
+     for (size_t i = 0; i < n; i++) {
+         if (p[i]) {
+             return 0;
+         }
+     }
+     return 1;
+ }
+
+ /**
+  * Function to write <size> bytes at <data> to the checkpoint file <path>. Pages that
+  * are all zero are skipped and read back as zeros from the holes they leave.
+  *
+  * @param path is the checkpoint file to create or overwrite
+  * @param data is the start of the arena
+  * @param size is the size of the arena in bytes
+  * @return 0 on success, -1 on error
+  */
+ int checkpoint_write(const char* path, const void* data, size_t size) {
+     int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+     if (fd < 0) {
+         perror("Unable to create checkpoint");
+         return -1;
+     }
+     const unsigned char* p = (const unsigned char*) data;
+     for (size_t off = 0; off < size; off += CHECKPOINT_PAGE) {
+         size_t n = (size - off < CHECKPOINT_PAGE) ? size - off : CHECKPOINT_PAGE;
+         if (all_zero(p + off, n)) {
+             continue;
+         }
+         if (pwrite(fd, p + off, n, (off_t) off) != (ssize_t) n) {
+             perror("Unable to write checkpoint");
+             close(fd);
+             return -1;
+         }
+     }
+     // Sets the size even if the arena ends in a hole
+     if (ftruncate(fd, (off_t) size) != 0 || close(fd) != 0) {
+         perror("Unable to write checkpoint");
+         return -1;
+     }
+     return 0;
+ }
+
+ /**
+  * Function to map the checkpoint file <path> into memory. Writes to the mapping are
+  * private to this process and never reach the file.
+  *
+  * @param path is the checkpoint file to map
+  * @param size is set to the size of the file in bytes
+  * @return the start of the mapping, or NULL on error
+  */
+ void* checkpoint_map(const char* path, size_t* size) {
+     int fd = open(path, O_RDONLY);
+     if (fd < 0) {
+         perror("Unable to open checkpoint");
+         return NULL;
+     }
+     struct stat st;
+     if (fstat(fd, &st) != 0 || st.st_size == 0) {
+         fprintf(stderr, "Unable to map checkpoint: %s is empty\n", path);
+         close(fd);
+         return NULL;
+     }
+     void* data = mmap(NULL, (size_t) st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+     close(fd); // The mapping keeps its own reference to the file
+     if (data == MAP_FAILED) {
+         perror("Unable to map checkpoint");
+         return NULL;
+     }
+     *size = (size_t) st.st_size;
+     return data;
+ }
+
+ /**
+  * Function to unmap a checkpoint mapped by checkpoint_map.
+  *
+  * @param data is the start of the mapping
+  * @param size is the size of the mapping in bytes
+  */
+ void checkpoint_unmap(void* data, size_t size) {
+     munmap(data, size);
+ }
@@ -0,0 +1,62 @@
+/**
+ * @author ECE 3058 TAs
+ */
+
+#ifndef __CHECKPOINT_H
+#define __CHECKPOINT_H
+
+#include <stddef.h>
+
+/**
+ * This file contains the file side of cache checkpoints. The cache state is a single
+ * position-independent arena (see cache_state_t in cachesim.h), so a checkpoint is
+ * the arena written out as is and a restore maps the file back in private
+ * (copy-on-write) mode. Pages are only read from disk when the simulation touches
+ * them and nothing is rebuilt line by line.
+ *
+ * A new arena is an anonymous mapping of zero pages, which the OS only backs with
+ * memory once they are written, so a huge cache over a sparse trace only costs the
+ * sets it touches. Pages that are still all zero are left as holes in the checkpoint
+ * file, so the checkpoint is just as sparse.
+ */
+
+#define CHECKPOINT_PAGE 4096
+
+/**
+ * Function to allocate an arena of <size> zero bytes. Pages take memory only once
+ * they are written.
+ *
+ * @param size is the size of the arena in bytes
+ * @return the start of the arena, or NULL on error
+ */
+void* checkpoint_alloc(size_t size);
+
+/**
+ * Function to write <size> bytes at <data> to the checkpoint file <path>.
+ *
+ * @param path is the checkpoint file to create or overwrite
+ * @param data is the start of the arena
+ * @param size is the size of the arena in bytes
+ * @return 0 on success, -1 on error
+ */
+int checkpoint_write(const char* path, const void* data, size_t size);
+
+/**
+ * Function to map the checkpoint file <path> into memory. Writes to the mapping are
+ * private to this process and never reach the file.
+ *
+ * @param path is the checkpoint file to map
+ * @param size is set to the size of the file in bytes
+ * @return the start of the mapping, or NULL on error
+ */
+void* checkpoint_map(const char* path, size_t* size);
+
+/**
+ * Function to unmap an arena from checkpoint_alloc or checkpoint_map.
+ *
+ * @param data is the start of the mapping
+ * @param size is the size of the mapping in bytes
+ */
+void checkpoint_unmap(void* data, size_t size);
+
+#endif
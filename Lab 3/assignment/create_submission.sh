@@ -1,6 +1,6 @@
 #!/bin/bash
 rm -f ece3058_cachelab_submission.tar.gz
-tar -czvf ece3058_cachelab_submission.tar.gz cachesim.c cachesim.h lrustack.c lrustack.h
+tar -czvf ece3058_cachelab_submission.tar.gz cachesim.c cachesim.h lrustack.c lrustack.h setindex.c setindex.h policy.c policy.h fullassoc.c fullassoc.h tagstore.h misstrace.c misstrace.h waypred.c waypred.h checkpoint.c checkpoint.h sampling.c sampling.h shards.c shards.h pagemap.c pagemap.h partition.c partition.h cachesimd.c cachesimd.h cachesim_client.c cachesim_replay.c dram.c dram.h timeseries.c timeseries.h nuca.c nuca.h deadblock.c deadblock.h tlb.c tlb.h
 echo "Done!"
 echo "The files that will be submitted are:"
 tar -ztvf ece3058_cachelab_submission.tar.gz
\ No newline at end of file
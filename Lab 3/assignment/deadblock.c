@@ -0,0 +1,89 @@
+/**
+ * @author ECE 3058 TAs
+ */
+
+ #include <stdio.h>
+ #include <string.h>
+ #include "deadblock.h"
+
+ int deadblock_kind = DEADBLOCK_NONE;
+ unsigned char deadblock_table[DEADBLOCK_TABLE_ENTRIES];
+ int deadblock_sample = 0;
+ int dip_psel = DIP_PSEL_MAX / 2;
+ int dip_stride = 2;
+ int bip_count = 0;
+ deadblock_counter_t deadblock_fills = 0;
+ deadblock_counter_t deadblock_bypassed = 0;
+ deadblock_counter_t deadblock_saved = 0;
+ deadblock_counter_t deadblock_low = 0;
+
+ static const char* deadblock_names[] = { "none", "bypass", "dip" };
+
+ /**
+  * Function to convert a mechanism name into a DEADBLOCK_* value.
+  *
+  * @param name is the name given on the command line
+  * @return the DEADBLOCK_* value, or -1 if the name is unknown
+  */
+ int deadblock_parse(const char* name) {
+     for (int i = 0; i < (int) (sizeof(deadblock_names) / sizeof(deadblock_names[0])); i++) {
+         if (strcmp(name, deadblock_names[i]) == 0) {
+             return i;
+         }
+     }
+     return -1;
+ }
+
+ /**
+  * Function to set up the predictor or the leader sets. The leaders are spread evenly
+  * over the sets: sets 0 and 1 of every group of <dip_stride>, for the first
+  * DIP_LEADER_SETS groups. With fewer than 2 * DIP_LEADER_SETS sets every set leads.
+  *
+  * @param sets is the number of sets
+  */
+ void deadblock_init(int sets) {
+     memset(deadblock_table, DEADBLOCK_COUNTER_INIT, sizeof(deadblock_table));
+     dip_stride = sets / DIP_LEADER_SETS;
+     if (dip_stride < 2) {
+         dip_stride = 2;
+     }
+ }
+
+ /**
+  * Function to reset the statistics. The predictor and PSEL are kept.
+  */
+ void deadblock_reset_stats() {
+     deadblock_fills = 0;
+     deadblock_bypassed = 0;
+     deadblock_saved = 0;
+     deadblock_low = 0;
+ }
+
+ /**
+  * Function to print the fills bypassed or inserted low, the writebacks saved, and the
+  * hit rate and writebacks against the run with the plain fill path. A bypass past a
+  * dirty victim defers that writeback rather than saving it outright, so the writebacks
+  * against the plain run are the net effect.
+  *
+  * @param accesses is the number of accesses
+  * @param hits is the number of hits
+  * @param writebacks is the number of writebacks
+  * @param plain_hits is the number of hits with the plain fill path
+  * @param plain_writebacks is the number of writebacks with the plain fill path
+  */
+ void deadblock_print_stats(unsigned long long accesses, unsigned long long hits, unsigned long long writebacks,
+                            unsigned long long plain_hits, unsigned long long plain_writebacks) {
+     double rate = accesses ? 100.0 * hits / accesses : 0.0;
+     double plain_rate = accesses ? 100.0 * plain_hits / accesses : 0.0;
+     if (deadblock_kind == DEADBLOCK_BYPASS) {
+         printf("dead-block: bypass, %llu of %llu fills bypassed (%.4f%%), %llu of them past a dirty victim",
+                deadblock_bypassed, deadblock_fills,
+                deadblock_fills ? 100.0 * deadblock_bypassed / deadblock_fills : 0.0, deadblock_saved);
+     } else {
+         printf("dead-block: dip, %llu of %llu fills inserted at LRU (%.4f%%), PSEL %d of %d (followers use %s)",
+                deadblock_low, deadblock_fills, deadblock_fills ? 100.0 * deadblock_low / deadblock_fills : 0.0,
+                dip_psel, DIP_PSEL_MAX, dip_psel > DIP_PSEL_MAX / 2 ? "bip" : "lru");
+     }
+     printf(", hit rate %.4f%% vs %.4f%% plain (%+.4f points), %llu writebacks vs %llu plain\n",
+            rate, plain_rate, rate - plain_rate, writebacks, plain_writebacks);
+ }
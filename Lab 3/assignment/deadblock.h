@@ -0,0 +1,162 @@
+/**
+ * @author ECE 3058 TAs
+ */
+
+#ifndef __DEADBLOCK_H
+#define __DEADBLOCK_H
+
+#include "policy.h"
+
+/**
+ * This file contains the dead-block mechanisms that keep streaming data, blocks that
+ * are never used again after they are filled, from pushing out blocks that are:
+ *  - bypass: a per-PC dead-block predictor. Every fill is tagged with its PC's entry
+ *  in a table of 2-bit counters, and the block's eviction trains the entry: up if the
+ *  block was hit at least once, down if it never was. A read or instruction fetch
+ *  miss whose entry is 0 is predicted dead on arrival and, if it would evict a valid
+ *  block, bypasses the cache: the block goes to the requester and nothing is evicted.
+ *  Every DEADBLOCK_SAMPLE_PERIOD-th predicted-dead fill is allocated anyway so the
+ *  entry can learn the PC has changed.
+ *  - dip: Dynamic Insertion Policy (Qureshi et al., ISCA '07). DIP_LEADER_SETS sets
+ *  always insert at the MRU position (LRU insertion) and as many always use BIP, which
+ *  inserts at the LRU position except for one fill in BIP_EPSILON. A saturating PSEL
+ *  counter counts up on misses in the first group and down in the second, and the
+ *  other sets follow whichever group misses less.
+ *
+ * The run with the plain fill path is simulated alongside in a child process, so the
+ * report can give the hit rate and writebacks each mechanism gained or lost.
+ *
+ * NOTES:
+ *      - Write misses always allocate, so the cache stays write-back.
+ *      - Only LRU with a set-associative index function and the scanned lookup is
+ *      supported.
+ *      - The predictor table is not part of a checkpoint.
+ */
+
+#define DEADBLOCK_NONE 0
+#define DEADBLOCK_BYPASS 1
+#define DEADBLOCK_DIP 2
+
+#define DEADBLOCK_TABLE_ENTRIES 4096    // Predictor entries, power of 2
+#define DEADBLOCK_COUNTER_MAX 3         // 2-bit saturating counters
+#define DEADBLOCK_COUNTER_INIT 1        // Weakly live, so a new PC starts out allocating
+#define DEADBLOCK_SAMPLE_PERIOD 32      // One predicted-dead fill in this many is allocated
+
+#define DIP_LEADER_SETS 32              // Leader sets of each insertion policy
+#define DIP_PSEL_MAX 1023               // 10-bit policy selector
+#define BIP_EPSILON 32                  // BIP inserts one fill in this many at MRU
+
+typedef unsigned long long deadblock_counter_t;
+
+extern int deadblock_kind;                  // Selected mechanism, DEADBLOCK_*
+extern unsigned char deadblock_table[DEADBLOCK_TABLE_ENTRIES];
+extern int deadblock_sample;                // Predicted-dead fills since the last allocated one
+extern int dip_psel;
+extern int dip_stride;                      // Every stride-th set leads for LRU insertion
+extern int bip_count;                       // BIP fills since the last MRU insertion
+extern deadblock_counter_t deadblock_fills;     // Misses seen
+extern deadblock_counter_t deadblock_bypassed;  // ...that bypassed the cache
+extern deadblock_counter_t deadblock_saved;     // ...leaving a dirty victim in place
+extern deadblock_counter_t deadblock_low;       // ...inserted at the LRU position
+
+/**
+ * Function to get the predictor entry of the instruction at <pc>.
+ */
+static inline unsigned short deadblock_slot(unsigned long long pc) {
+    return (unsigned short) (((pc >> 2) ^ (pc >> 14)) & (DEADBLOCK_TABLE_ENTRIES - 1));
+}
+
+/**
+ * Function to decide whether a read miss of the instruction at <pc> bypasses the cache.
+ *
+ * @return 1 to bypass, 0 to allocate
+ */
+static inline int deadblock_bypass(unsigned long long pc) {
+    if (deadblock_table[deadblock_slot(pc)] != 0) {
+        return 0;
+    }
+    if (++deadblock_sample == DEADBLOCK_SAMPLE_PERIOD) {
+        deadblock_sample = 0;
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * Function to train the predictor with valid block <b> as it is evicted.
+ */
+static inline void deadblock_evict(cache_block_t* b) {
+    unsigned char* c = &deadblock_table[b->signature];
+    if (b->flags & BLOCK_REUSED) {
+        if (*c < DEADBLOCK_COUNTER_MAX) {
+            (*c)++;
+        }
+    } else if (*c > 0) {
+        (*c)--;
+    }
+}
+
+/**
+ * Function to get the role of <set> under DIP: 1 if it always inserts with LRU
+ * insertion, 2 if it always uses BIP, 0 if it follows PSEL.
+ */
+static inline int dip_role(int set) {
+    int r = set % dip_stride;
+    return (r < 2 && set / dip_stride < DIP_LEADER_SETS) ? r + 1 : 0;
+}
+
+/**
+ * Function to count a miss in <set> and decide where its fill goes under DIP.
+ *
+ * @return 1 to insert at the LRU position, 0 to insert at the MRU position
+ */
+static inline int dip_fill(int set) {
+    int role = dip_role(set);
+    if (role == 1 && dip_psel < DIP_PSEL_MAX) {
+        dip_psel++;
+    } else if (role == 2 && dip_psel > 0) {
+        dip_psel--;
+    }
+    if (role == 1 || (role == 0 && dip_psel <= DIP_PSEL_MAX / 2)) {
+        return 0;
+    }
+    if (++bip_count == BIP_EPSILON) {
+        bip_count = 0;
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * Function to convert a mechanism name ("bypass", "dip") into a DEADBLOCK_* value.
+ *
+ * @return the DEADBLOCK_* value, or -1 if the name is unknown
+ */
+int deadblock_parse(const char* name);
+
+/**
+ * Function to set up the predictor or the leader sets.
+ *
+ * @param sets is the number of sets
+ */
+void deadblock_init(int sets);
+
+/**
+ * Function to reset the statistics. The predictor and PSEL are kept.
+ */
+void deadblock_reset_stats(void);
+
+/**
+ * Function to print the fills bypassed or inserted low, the writebacks saved, and the
+ * hit rate and writebacks against the run with the plain fill path.
+ *
+ * @param accesses is the number of accesses
+ * @param hits is the number of hits
+ * @param writebacks is the number of writebacks
+ * @param plain_hits is the number of hits with the plain fill path
+ * @param plain_writebacks is the number of writebacks with the plain fill path
+ */
+void deadblock_print_stats(unsigned long long accesses, unsigned long long hits, unsigned long long writebacks,
+                           unsigned long long plain_hits, unsigned long long plain_writebacks);
+
+#endif
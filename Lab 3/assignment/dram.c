@@ -0,0 +1,449 @@
+/**
+ * @author ECE 3058 TAs
+ */
+
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include "dram.h"
+
+ #define DRAM_LATENCY_BUCKETS 4096  // Read latency histogram, the last bucket counts the rest
+
+ dram_config_t dram_config = {
+     1, 1, 8, 65536, 8192, "rorabachco", 1, 32, 2,
+     16, 12, 16, 16, 39, 18, 4, 9, 8
+ };
+
+ /**
+  * One request in a channel queue.
+  */
+ typedef struct dram_request_t {
+     unsigned long long arrival;
+     int bank;               // Rank * banks + bank
+     int write;
+     long long row;
+ } dram_request_t;
+
+ /**
+  * State of one bank.
+  */
+ typedef struct dram_bank_t {
+     long long open_row;         // -1 when precharged
+     unsigned long long ready;   // Earliest next command
+     unsigned long long act;     // Last activate, for tRAS
+     unsigned long long pre;     // Earliest precharge, for tRAS and tWR
+ } dram_bank_t;
+
+ /**
+  * State of one channel.
+  */
+ typedef struct dram_channel_t {
+     dram_request_t* queue;      // In arrival order
+     int count;
+     unsigned long long* issued; // When each scheduled request leaves the queue
+     int issued_count;
+     unsigned long long clock;   // Earliest next scheduling decision
+     unsigned long long bus_free; // End of the last data transfer
+     int last_write;             // Direction of the last data transfer, -1 before the first
+     dram_bank_t* banks;
+     dram_counter_t busy;        // Data bus cycles used
+ } dram_channel_t;
+
+ static dram_channel_t* channels;
+ static int burst_bits;
+ static int field_bits[5];       // Bits of ro, ra, ba, ch, co
+ static int field_order[5];      // Fields from least to most significant
+ static int num_fields;
+ static unsigned long long last_arrival = 0;
+ static unsigned long long first_arrival = ~0ULL; // First arrival since the statistics were reset
+ static unsigned long long last_finish = 0;
+
+ static dram_counter_t reads = 0;
+ static dram_counter_t writes = 0;
+ static dram_counter_t row_hits = 0;
+ static dram_counter_t row_conflicts = 0;     // Another row was open
+ static dram_counter_t stall_cycles = 0;      // Cycles arrivals waited for a queue entry
+ static unsigned long long arrival_delay = 0; // Total of those, pushing back later arrivals
+ static dram_counter_t read_latency_sum = 0;
+ static dram_counter_t read_latency[DRAM_LATENCY_BUCKETS];
+
+ static const char* field_names[] = { "ro", "ra", "ba", "ch", "co" };
+
+ /**
+  * Function to get log2 of <x>, or -1 if <x> is not a power of 2.
+  */
+ static int log2_exact(long long x) {
+     int bits = 0;
+     if (x < 1 || (x & (x - 1)) != 0) {
+         return -1;
+     }
+     while ((1LL << bits) < x) {
+         bits++;
+     }
+     return bits;
+ }
+
+ /**
+  * Function to apply a --dram specification: "default", or a comma separated list of
+  * key=value settings on top of the defaults.
+  *
+  * @param spec is the option argument
+  * @return 0 on success, -1 on error
+  */
+ int dram_parse(const char* spec) {
+     if (strcmp(spec, "default") == 0) {
+         return 0;
+     }
+     char buf[256];
+     if (strlen(spec) >= sizeof(buf)) {
+         fprintf(stderr, "--dram specification too long\n");
+         return -1;
+     }
+     strcpy(buf, spec);
+     struct { const char* key; int* value; } keys[] = {
+         { "channels", &dram_config.channels }, { "ranks", &dram_config.ranks },
+         { "banks", &dram_config.banks }, { "rows", &dram_config.rows },
+         { "row", &dram_config.row_bytes }, { "queue", &dram_config.queue },
+         { "gap", &dram_config.gap }, { "tcl", &dram_config.tCL }, { "tcwl", &dram_config.tCWL },
+         { "trcd", &dram_config.tRCD }, { "trp", &dram_config.tRP }, { "tras", &dram_config.tRAS },
+         { "twr", &dram_config.tWR }, { "tburst", &dram_config.tBURST },
+         { "twtr", &dram_config.tWTR }, { "trtw", &dram_config.tRTW },
+     };
+     for (char* item = strtok(buf, ","); item; item = strtok(NULL, ",")) {
+         char* value = strchr(item, '=');
+         if (!value) {
+             fprintf(stderr, "Expected key=value in --dram, got %s\n", item);
+             return -1;
+         }
+         *value++ = '\0';
+         if (strcmp(item, "map") == 0) {
+             if (strlen(value) >= sizeof(dram_config.map)) {
+                 fprintf(stderr, "Unknown DRAM address mapping: %s\n", value);
+                 return -1;
+             }
+             strcpy(dram_config.map, value);
+             continue;
+         }
+         if (strcmp(item, "page") == 0) {
+             if (strcmp(value, "open") != 0 && strcmp(value, "closed") != 0) {
+                 fprintf(stderr, "Expected page=open or page=closed, got %s\n", value);
+                 return -1;
+             }
+             dram_config.open_page = (strcmp(value, "open") == 0);
+             continue;
+         }
+         int found = 0;
+         for (int i = 0; i < (int) (sizeof(keys) / sizeof(keys[0])); i++) {
+             if (strcmp(item, keys[i].key) == 0) {
+                 *keys[i].value = atoi(value);
+                 found = 1;
+             }
+         }
+         if (!found) {
+             fprintf(stderr, "Unknown --dram setting: %s\n", item);
+             return -1;
+         }
+     }
+     return 0;
+ }
+
+ /**
+  * Function to check the configuration and set up the channels and banks.
+  *
+  * @param block_size is the cache block size, the size of every request
+  * @return 0 on success, -1 on error
+  */
+ int dram_init(int block_size) {
+     dram_config_t* c = &dram_config;
+     burst_bits = log2_exact(block_size);
+     field_bits[0] = log2_exact(c->rows);
+     field_bits[1] = log2_exact(c->ranks);
+     field_bits[2] = log2_exact(c->banks);
+     field_bits[3] = log2_exact(c->channels);
+     field_bits[4] = log2_exact(c->row_bytes / block_size);
+     for (int f = 0; f < 5; f++) {
+         if (field_bits[f] < 0 || c->row_bytes < block_size) {
+             fprintf(stderr, "DRAM channels, ranks, banks, rows and blocks per row must be powers of 2\n");
+             return -1;
+         }
+     }
+     if (c->queue < 1 || c->gap < 0 || c->tCL < 0 || c->tCWL < 0 || c->tRCD < 0 || c->tRP < 0
+         || c->tRAS < 0 || c->tWR < 0 || c->tBURST < 1 || c->tWTR < 0 || c->tRTW < 0) {
+         fprintf(stderr, "DRAM timings must not be negative and the queue must have an entry\n");
+         return -1;
+     }
+     // The mapping lists every field once, most significant first
+     num_fields = 0;
+     int seen = 0;
+     int len = (int) strlen(c->map);
+     for (int i = len - 2; i >= 0 && len == 10; i -= 2) {
+         int f = 0;
+         while (f < 5 && strncmp(&c->map[i], field_names[f], 2) != 0) {
+             f++;
+         }
+         if (f == 5 || (seen & (1 << f))) {
+             break;
+         }
+         seen |= 1 << f;
+         field_order[num_fields++] = f;
+     }
+     if (num_fields != 5) {
+         fprintf(stderr, "The DRAM mapping must name ro, ra, ba, ch and co once each, got %s\n", c->map);
+         return -1;
+     }
+
+     channels = (dram_channel_t*) calloc(c->channels, sizeof(dram_channel_t));
+     for (int i = 0; i < c->channels; i++) {
+         channels[i].queue = (dram_request_t*) malloc(sizeof(dram_request_t) * c->queue);
+         channels[i].issued = (unsigned long long*) malloc(sizeof(unsigned long long) * c->queue);
+         channels[i].banks = (dram_bank_t*) calloc((size_t) c->ranks * c->banks, sizeof(dram_bank_t));
+         channels[i].last_write = -1;
+         for (int b = 0; b < c->ranks * c->banks; b++) {
+             channels[i].banks[b].open_row = -1;
+         }
+     }
+     return 0;
+ }
+
+ /**
+  * Function to drop the scheduled requests of <ch> that left the queue by time <t>.
+  */
+ static void retire(dram_channel_t* ch, unsigned long long t) {
+     int n = 0;
+     for (int i = 0; i < ch->issued_count; i++) {
+         if (ch->issued[i] > t) {
+             ch->issued[n++] = ch->issued[i];
+         }
+     }
+     ch->issued_count = n;
+ }
+
+ /**
+  * Function to serve request <i> of channel <ch>, scheduled at time <t>. The request
+  * keeps its queue entry until its column command is issued.
+  */
+ static void serve(dram_channel_t* ch, int i, unsigned long long t) {
+     dram_config_t* c = &dram_config;
+     dram_request_t r = ch->queue[i];
+     dram_bank_t* b = &ch->banks[r.bank];
+     unsigned long long start = (t > b->ready) ? t : b->ready;
+     unsigned long long col;
+     if (b->open_row == r.row) {
+         col = start;
+         row_hits++;
+     } else {
+         unsigned long long act = start;
+         if (b->open_row >= 0) {
+             unsigned long long pre = (start > b->pre) ? start : b->pre;
+             act = pre + c->tRP;
+             row_conflicts++;
+         }
+         b->act = act;
+         col = act + c->tRCD;
+     }
+
+     unsigned long long data = col + (r.write ? c->tCWL : c->tCL);
+     unsigned long long bus = ch->bus_free;
+     if (ch->last_write >= 0 && ch->last_write != r.write) {
+         bus += r.write ? c->tRTW : c->tWTR;
+     }
+     if (data < bus) {
+         data = bus;
+     }
+     unsigned long long finish = data + c->tBURST;
+     ch->bus_free = finish;
+     ch->last_write = r.write;
+     ch->busy += c->tBURST;
+
+     // The row can be precharged once the read burst is out or tWR after the write
+     // data, and tRAS after its activate. An open row keeps the latest of these over
+     // all of its accesses, for the next conflict.
+     unsigned long long pre = r.write ? finish + c->tWR : col + c->tBURST;
+     if (pre < b->act + c->tRAS) {
+         pre = b->act + c->tRAS;
+     }
+     if (pre > b->pre) {
+         b->pre = pre;
+     }
+     if (c->open_page) {
+         b->open_row = r.row;
+         b->ready = col + c->tBURST;
+     } else {
+         b->open_row = -1;
+         b->ready = b->pre + c->tRP;
+     }
+
+     if (r.write) {
+         writes++;
+     } else {
+         unsigned long long latency = finish - r.arrival;
+         reads++;
+         read_latency_sum += latency;
+         read_latency[latency < DRAM_LATENCY_BUCKETS ? latency : DRAM_LATENCY_BUCKETS - 1]++;
+     }
+     if (finish > last_finish) {
+         last_finish = finish;
+     }
+     memmove(&ch->queue[i], &ch->queue[i + 1], sizeof(dram_request_t) * (ch->count - i - 1));
+     ch->count--;
+     retire(ch, t);
+     ch->issued[ch->issued_count++] = data - (r.write ? c->tCWL : c->tCL);
+     ch->clock = t + 1;
+ }
+
+ /**
+  * Function to make the next scheduling decision of <ch>: FR-FCFS among the requests
+  * that have arrived by the time the channel can decide.
+  */
+ static void schedule(dram_channel_t* ch) {
+     unsigned long long t = (ch->clock > ch->queue[0].arrival) ? ch->clock : ch->queue[0].arrival;
+     int pick = 0;
+     for (int i = 0; i < ch->count && ch->queue[i].arrival <= t; i++) {
+         if (ch->banks[ch->queue[i].bank].open_row == ch->queue[i].row) {
+             pick = i;
+             break;
+         }
+     }
+     serve(ch, pick, t);
+ }
+
+ /**
+  * Function to send one request to DRAM. Decisions the channel would have made before
+  * the request arrives are made first, so the request only competes with the ones
+  * still queued at that time. A request that finds the queue full waits for an entry,
+  * and so does everything after it, like a core stalled on a full memory controller.
+  *
+  * @param addr is the block-aligned address
+  * @param write is 1 for a writeback, 0 for a fill
+  * @param index is the index of the access that caused it in the original trace
+  */
+ void dram_access(unsigned long long addr, int write, unsigned long long index) {
+     unsigned long long arrival = index * (unsigned long long) dram_config.gap + arrival_delay;
+     if (arrival < last_arrival) {
+         arrival = last_arrival;
+     }
+     last_arrival = arrival;
+     if (arrival < first_arrival) {
+         first_arrival = arrival;
+     }
+
+     unsigned long long rest = addr >> burst_bits;
+     unsigned long long field[5];
+     for (int i = 0; i < num_fields; i++) {
+         int f = field_order[i];
+         field[f] = rest & ((1ULL << field_bits[f]) - 1);
+         rest >>= field_bits[f];
+     }
+     dram_channel_t* ch = &channels[field[3]];
+     for (;;) {
+         while (ch->count > 0 && ((ch->clock > ch->queue[0].arrival) ? ch->clock : ch->queue[0].arrival) < arrival) {
+             schedule(ch);
+         }
+         retire(ch, arrival);
+         if (ch->count + ch->issued_count < dram_config.queue) {
+             break;
+         }
+         if (ch->issued_count == 0) {
+             schedule(ch);
+             continue;
+         }
+         unsigned long long next = ch->issued[0];
+         for (int i = 1; i < ch->issued_count; i++) {
+             next = (ch->issued[i] < next) ? ch->issued[i] : next;
+         }
+         stall_cycles += next - arrival;
+         arrival_delay += next - arrival;
+         arrival = next;
+     }
+     last_arrival = arrival;
+     dram_request_t* r = &ch->queue[ch->count++];
+     r->arrival = arrival;
+     r->bank = (int) (field[1] * dram_config.banks + field[2]);
+     r->write = write;
+     r->row = (long long) field[0];
+ }
+
+ /**
+  * Function to serve every request still queued.
+  */
+ void dram_finish() {
+     for (int i = 0; i < dram_config.channels; i++) {
+         while (channels[i].count > 0) {
+             schedule(&channels[i]);
+         }
+     }
+ }
+
+ /**
+  * Function to reset the statistics, e.g. at the end of the warm-up window. Open rows
+  * and queued requests are kept.
+  */
+ void dram_reset_stats() {
+     reads = 0;
+     writes = 0;
+     row_hits = 0;
+     row_conflicts = 0;
+     stall_cycles = 0;
+     read_latency_sum = 0;
+     memset(read_latency, 0, sizeof(read_latency));
+     first_arrival = ~0ULL;
+     last_finish = 0;
+     for (int i = 0; i < dram_config.channels; i++) {
+         channels[i].busy = 0;
+     }
+ }
+
+ /**
+  * Function to get the read latency below which <fraction> of the reads fall.
+  */
+ static int latency_percentile(double fraction) {
+     dram_counter_t target = (dram_counter_t) (fraction * reads + 0.5), seen = 0;
+     for (int i = 0; i < DRAM_LATENCY_BUCKETS; i++) {
+         seen += read_latency[i];
+         if (seen >= target && seen > 0) {
+             return i;
+         }
+     }
+     return DRAM_LATENCY_BUCKETS - 1;
+ }
+
+ /**
+  * Function to print the configuration, the row hit rate, the read latency, the bus
+  * utilization, i.e. the fraction of the time from the first arrival to the last
+  * transfer that the data buses were busy, and the cycles spent waiting for a full queue.
+  */
+ void dram_print_stats() {
+     dram_config_t* c = &dram_config;
+     dram_counter_t busy = 0;
+     for (int i = 0; i < c->channels; i++) {
+         busy += channels[i].busy;
+     }
+     dram_counter_t requests = reads + writes;
+     unsigned long long span = (requests && last_finish > first_arrival) ? last_finish - first_arrival : 0;
+     printf("dram: %d channels, %d ranks, %d banks, %d-byte rows, map %s, %s page, FR-FCFS queue %d\n",
+            c->channels, c->ranks, c->banks, c->row_bytes, c->map, c->open_page ? "open" : "closed",
+            c->queue);
+     printf("dram: %llu reads, %llu writes, row hit rate %.4f%% (%llu conflicts), read latency avg %.2f"
+            " p50 %d p95 %d p99 %d%s cycles, bus utilization %.4f%%, %llu cycles stalled on a full queue\n",
+            reads, writes, requests ? 100.0 * row_hits / requests : 0.0, row_conflicts,
+            reads ? (double) read_latency_sum / reads : 0.0, latency_percentile(0.50),
+            latency_percentile(0.95), latency_percentile(0.99),
+            read_latency[DRAM_LATENCY_BUCKETS - 1] ? "+" : "",
+            span ? 100.0 * busy / ((double) span * c->channels) : 0.0, stall_cycles);
+ }
+
+ /**
+  * Function to free the channels.
+  */
+ void dram_cleanup() {
+     if (!channels) {
+         return;
+     }
+     for (int i = 0; i < dram_config.channels; i++) {
+         free(channels[i].queue);
+         free(channels[i].issued);
+         free(channels[i].banks);
+     }
+     free(channels);
+     channels = NULL;
+ }
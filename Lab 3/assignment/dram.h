@@ -0,0 +1,113 @@
+/**
+ * @author ECE 3058 TAs
+ */
+
+#ifndef __DRAM_H
+#define __DRAM_H
+
+/**
+ * This file contains the DRAM timing model behind the cache. With --dram every miss
+ * of the cache becomes a read of its block from DRAM and every writeback a write, and
+ * the model works out when each request is served:
+ *  - the block address is split into channel, rank, bank, row and column by a
+ *  configurable mapping, e.g. rorabachco (most to least significant field)
+ *  - every bank has an open row. Under the open page policy a row stays open after an
+ *  access, so the next access to it is a row hit that needs only a column command; an
+ *  access to another row has to precharge and activate first. Under the closed page
+ *  policy every access activates its row and precharges it afterwards.
+ *  - every channel has a request queue scheduled FR-FCFS: the oldest request that hits
+ *  an open row goes first, otherwise the oldest request.
+ *  - every channel has one data bus. A change of direction between reads and writes
+ *  pays the write-to-read (tWTR) or read-to-write (tRTW) turnaround.
+ * Requests arrive <gap> DRAM cycles apart per trace line, using the index of the access
+ * in the original trace, so a miss trace keeps the timing of the trace it came from.
+ * A request holds its queue entry until its column command. One that finds the queue
+ * full waits for an entry, and every later request arrives that much later.
+ *
+ * All times are in DRAM clock cycles. The default timing is roughly DDR4-2400.
+ *
+ * NOTES:
+ *      - Refresh, rank-to-rank switching and the four-activate window are not modeled.
+ *      - Writes are posted, so only read latency is reported; writes still occupy banks
+ *      and the bus.
+ *      - Open rows, the queue and the counters are not part of a checkpoint, so --dram
+ *      cannot be combined with --checkpoint or --restore.
+ */
+
+typedef unsigned long long dram_counter_t;
+
+/**
+ * DRAM organization, mapping and timing, set with --dram=key=value,...
+ */
+typedef struct dram_config_t {
+    int channels;
+    int ranks;              // Ranks per channel
+    int banks;              // Banks per rank
+    int rows;               // Rows per bank
+    int row_bytes;          // Bytes per row, per rank
+    char map[16];           // Address mapping, fields from most to least significant
+    int open_page;          // 1 for the open page policy, 0 for closed page
+    int queue;              // Request queue entries per channel
+    int gap;                // DRAM cycles between trace lines
+    int tCL;                // Column command to read data
+    int tCWL;               // Column command to write data
+    int tRCD;               // Activate to column command
+    int tRP;                // Precharge to activate
+    int tRAS;               // Activate to precharge
+    int tWR;                // End of write data to precharge
+    int tBURST;             // Data bus cycles per block
+    int tWTR;               // End of write data to read data
+    int tRTW;               // End of read data to write data
+} dram_config_t;
+
+extern dram_config_t dram_config;
+
+/**
+ * Function to apply a --dram specification: "default", or a comma separated list of
+ * key=value settings on top of the defaults (channels, ranks, banks, rows, row, map,
+ * page, queue, gap, tcl, tcwl, trcd, trp, tras, twr, tburst, twtr, trtw).
+ *
+ * @return 0 on success, -1 on error
+ */
+int dram_parse(const char* spec);
+
+/**
+ * Function to check the configuration and set up the channels and banks.
+ *
+ * @param block_size is the cache block size, the size of every request
+ * @return 0 on success, -1 on error
+ */
+int dram_init(int block_size);
+
+/**
+ * Function to send one request to DRAM.
+ *
+ * @param addr is the block-aligned address
+ * @param write is 1 for a writeback, 0 for a fill
+ * @param index is the index of the access that caused it in the original trace
+ */
+void dram_access(unsigned long long addr, int write, unsigned long long index);
+
+/**
+ * Function to serve every request still queued.
+ */
+void dram_finish(void);
+
+/**
+ * Function to reset the statistics, e.g. at the end of the warm-up window. Open rows
+ * and queued requests are kept.
+ */
+void dram_reset_stats(void);
+
+/**
+ * Function to print the configuration, the row hit rate, the read latency, the bus
+ * utilization and the cycles spent waiting for a full queue.
+ */
+void dram_print_stats(void);
+
+/**
+ * Function to free the channels.
+ */
+void dram_cleanup(void);
+
+#endif
@@ -0,0 +1,64 @@
+/**
+ * @author ECE 3058 TAs
+ */
+
+ #include "fullassoc.h"
+
+ /**
+  * Function to set up the list of <set>, which has no valid blocks yet. Way 0 starts
+  * as the MRU way and the last way as the LRU way, like a fresh LRU stack.
+  *
+  * @param fa is the view of the structures
+  * @param set is the set to set up
+  */
+ void fa_init_set(fa_t* fa, int set) {
+     fa_link_t* links = &fa->links[(size_t) set * fa->ways];
+     for (int w = 0; w < fa->ways; w++) {
+         links[w].prev = w - 1;
+         links[w].next = (w + 1 < fa->ways) ? w + 1 : -1;
+     }
+     fa->lists[set].head = 0;
+     fa->lists[set].tail = fa->ways - 1;
+     fa->lists[set].filled = 0;
+ }
+
+ /**
+  * Function to add the valid line <line> (index into the lines array) of <set> to the hash.
+  *
+  * @param fa is the view of the structures
+  * @param set is the set of the line
+  * @param line is the index of the line
+  */
+ void fa_insert(fa_t* fa, int set, unsigned line) {
+     unsigned i = fa_home(fa, set, tag_get(&fa->tags, line));
+     while (fa->slots[i] != 0) {
+         i = (i + 1) & fa->mask;
+     }
+     fa->slots[i] = line + 1;
+ }
+
+ /**
+  * Function to remove the valid line <line> of <set> from the hash, before its tag
+  * changes. The entries after it in the probe run are shifted back, so lookups never
+  * need tombstones.
+  *
+  * @param fa is the view of the structures
+  * @param set is the set of the line
+  * @param line is the index of the line
+  */
+ void fa_remove(fa_t* fa, int set, unsigned line) {
+     unsigned i = fa_home(fa, set, tag_get(&fa->tags, line));
+     while (fa->slots[i] != line + 1) {
+         i = (i + 1) & fa->mask;
+     }
+     for (unsigned j = (i + 1) & fa->mask; fa->slots[j] != 0; j = (j + 1) & fa->mask) {
+         unsigned e = fa->slots[j] - 1;
+         unsigned home = fa_home(fa, (int) (e / fa->ways), tag_get(&fa->tags, e));
+         // Move the entry back unless its home lies cyclically in (i, j]
+         if (((j - home) & fa->mask) >= ((j - i) & fa->mask)) {
+             fa->slots[i] = fa->slots[j];
+             i = j;
+         }
+     }
+     fa->slots[i] = 0;
+ }
@@ -0,0 +1,141 @@
+/**
+ * @author ECE 3058 TAs
+ */
+
+#ifndef __FULLASSOC_H
+#define __FULLASSOC_H
+
+#include "cachesim.h"
+#include "tagstore.h"
+
+/**
+ * This file contains the hashed lookup used for fully associative and highly
+ * associative caches, where scanning a set and updating an LRU stack are both
+ * O(ways). Two structures replace them:
+ *  - an open-addressing hash (linear probing) from (set, tag) to the line holding it,
+ *  so a lookup costs O(1) expected probes whatever the associativity
+ *  - an intrusive doubly linked list through the ways of each set, most recently used
+ *  first, so promoting a block and finding the LRU block are both O(1)
+ *
+ * NOTES:
+ *      - Everything is stored as indices into arrays of the cache state arena, so the
+ *      structures are checkpointed and restored along with the blocks.
+ *      - Blocks are never invalidated, so the valid ways of a set are always ways
+ *      0 to filled - 1 and the next invalid way is known without a scan.
+ *      - Every way is on its set's list from the start, in the order the LRU stack
+ *      starts in, so the replacement order matches the LRU stack exactly.
+ *      - An empty hash is all zeros, so it needs no setup and only the pages it is
+ *      written to take memory. Lists are set up when their set is first touched.
+ */
+
+/**
+ * Links of one way in its set's LRU list. -1 marks the ends of the list.
+ */
+typedef struct fa_link_t {
+    int prev;               // Next more recently used way
+    int next;               // Next less recently used way
+} fa_link_t;
+
+/**
+ * LRU list and fill count of one set.
+ */
+typedef struct fa_list_t {
+    int head;               // MRU way
+    int tail;               // LRU way
+    int filled;             // Ways 0 to filled - 1 are valid
+} fa_list_t;
+
+/**
+ * View of the hashed lookup structures in the cache state arena.
+ */
+typedef struct fa_t {
+    unsigned* slots;        // Line index + 1 of each hash slot, 0 when empty
+    unsigned mask;          // Hash slots - 1, the slot count is a power of 2
+    int bits;               // log2 of the hash slots
+    fa_link_t* links;       // LRU links of every line, <ways> per set
+    fa_list_t* lists;       // LRU list of every set
+    tag_store_t tags;       // Tags of all cache blocks, one set after another
+    int ways;
+} fa_t;
+
+/**
+ * Function to get the number of hash bits for a cache of <n> lines, so the table is
+ * at most half full.
+ */
+static inline int fa_hash_bits(unsigned long long n) {
+    int bits = 1;
+    while ((1ULL << bits) < 2 * n) {
+        bits++;
+    }
+    return bits;
+}
+
+/**
+ * Function to get the home slot of (<set>, <tag>).
+ */
+static inline unsigned fa_home(fa_t* fa, int set, tag_t tag) {
+    unsigned long long key = (tag ^ ((unsigned long long) (unsigned) set << 40)) * 0x9E3779B97F4A7C15ULL;
+    return (unsigned) ((key ^ (key >> 29)) * 0xBF58476D1CE4E5B9ULL >> (64 - fa->bits));
+}
+
+/**
+ * Function to find the way of <set> holding <tag>.
+ *
+ * @return the way that hit, or -1 on a miss
+ */
+static inline int fa_lookup(fa_t* fa, int set, tag_t tag) {
+    unsigned base = (unsigned) set * fa->ways;
+    for (unsigned i = fa_home(fa, set, tag);; i = (i + 1) & fa->mask) {
+        unsigned e = fa->slots[i];
+        if (e == 0) {
+            return -1;
+        }
+        unsigned w = e - 1 - base;  // Wraps past ways for lines of other sets
+        if (w < (unsigned) fa->ways && tag_get(&fa->tags, e - 1) == tag) {
+            return (int) w;
+        }
+    }
+}
+
+/**
+ * Function to move way <w> of <set> to the MRU end of the set's list.
+ */
+static inline void fa_touch(fa_t* fa, int set, int w) {
+    fa_list_t* l = &fa->lists[set];
+    fa_link_t* links = &fa->links[(size_t) set * fa->ways];
+    if (l->head == w) {
+        return;
+    }
+    // Unlink; w is not the head, so it has a predecessor
+    links[links[w].prev].next = links[w].next;
+    if (links[w].next >= 0) {
+        links[links[w].next].prev = links[w].prev;
+    } else {
+        l->tail = links[w].prev;
+    }
+    links[w].prev = -1;
+    links[w].next = l->head;
+    links[l->head].prev = w;
+    l->head = w;
+}
+
+/**
+ * Function to set up the list of <set>, which has no valid blocks yet.
+ *
+ * @param fa is the view of the structures
+ * @param set is the set to set up
+ */
+void fa_init_set(fa_t* fa, int set);
+
+/**
+ * Function to add the valid line <line> (index into the lines array) of <set> to the hash.
+ */
+void fa_insert(fa_t* fa, int set, unsigned line);
+
+/**
+ * Function to remove the valid line <line> of <set> from the hash, before its tag
+ * changes.
+ */
+void fa_remove(fa_t* fa, int set, unsigned line);
+
+#endif
@@ -44,6 +44,17 @@
   * @return the dynamically allocated stack. 
   */
  lru_stack_t* init_lru_stack(int size);
+
+ /**
+  * Function to initialize an LRU stack whose ranks live in storage owned by the caller,
+  * such as the cache state arena. Nothing is allocated, so the stack must not be passed
+  * to lru_stack_cleanup.
+  *
+  * @param stack is the stack to initialize.
+  * @param size is the size of the LRU stack.
+  * @param indicies is storage for <size> ranks.
+  */
+ void lru_stack_init_at(lru_stack_t* stack, int size, int* indicies);
  
  /**
   * Function to get the index of the least recently used cache block, as indicated by <stack>.
@@ -2,8 +2,43 @@
  * @author ECE 3058 TAs
  */
 
+/**
+ * This file contains the LRU stack tests and a microbenchmark of the replacement state
+ * implementations the simulator uses:
+ *  - lru-stack: the LRU stack of lrustack.h, one rank per way
+ *  - lru-list: the O(1) LRU lists of the hashed lookup, see fullassoc.h
+ *  - srrip: the RRPVs of the SRRIP policy, see policy.h
+ * Each is timed on streams of set-MRU/get-LRU operations over many sets, for 2 to 64
+ * ways and three patterns of ways: random, cyclic (every way of a set in turn, so the
+ * LRU block is always the one touched) and skewed (Zipf distributed, mostly the same
+ * few ways). Where perf_event_open is available the L1D and last-level cache misses
+ * are counted too, so a regression in the replacement hot path shows up on its own.
+ *
+ * Build it with:
+ *   gcc -O2 -o lrustacktest lrustacktest.c lrustack.c fullassoc.c policy.c
+ * and run "./lrustacktest" for the tests, or "./lrustacktest --bench [--ops=n] [--sets=n]".
+ */
+
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <getopt.h>
+#include <unistd.h>
 #include "lrustack.h"
+#include "cachesim.h"
+#include "fullassoc.h"
+#include "policy.h"
+#ifdef __linux__
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+#define BENCH_DEFAULT_OPS 4000000   // Operations timed per run
+#define BENCH_DEFAULT_SETS 4096     // Sets the operations are spread over
+#define BENCH_PATTERN_LENGTH 65536  // Operations generated, replayed until the run is done
+#define BENCH_MAX_WAYS 64
 
 int test_num = 1;
 
@@ -59,13 +94,278 @@ void run_student_tests() {
     ////////////////////////////////////////////////////////////////////
     //  Optional: Add any additional tests for your LRU stack implementation. 
     ////////////////////////////////////////////////////////////////////
-
+    // The LRU stack and the LRU lists of the hashed lookup must agree on the LRU
+    // block after every operation of a random stream, at every associativity
+    for (int size = 2; size <= BENCH_MAX_WAYS; size *= 2) {
+        lru_stack_t* stack = init_lru_stack(size);
+        fa_link_t links[BENCH_MAX_WAYS];
+        fa_list_t list;
+        fa_t fa = { NULL, 0, 0, links, &list, { NULL, 0 }, size };
+        fa_init_set(&fa, 0);
+        int disagreements = 0;
+        srand(size);
+        for (int i = 0; i < 10000; i++) {
+            int w = rand() % size;
+            lru_stack_set_mru(stack, w);
+            fa_touch(&fa, 0, w);
+            disagreements += (lru_stack_get_lru(stack) != list.tail);
+        }
+        assert_equal(test_num++, 0, disagreements);
+        lru_stack_cleanup(stack);
+    }
     ////////////////////////////////////////////////////////////////////
     //  End of your code   
     ////////////////////////////////////////////////////////////////////
 }
 
-int main() {
+// Replacement state of every implementation, for <bench_sets> sets
+static int bench_sets = BENCH_DEFAULT_SETS;
+static lru_stack_t* stacks;
+static fa_t fa;
+static cache_block_t* blocks;
+static volatile int sink;   // Keeps the victims from being optimized away
+
+static int pattern_sets[BENCH_PATTERN_LENGTH];
+static int pattern_ways[BENCH_PATTERN_LENGTH];
+
+static const char* pattern_names[] = { "random", "cyclic", "skewed" };
+static const char* impl_names[] = { "lru-stack", "lru-list", "srrip" };
+
+/**
+ * Function to generate a stream of operations: a random set each, and a way of it
+ * chosen by <pattern> (0 random, 1 cyclic, 2 skewed).
+ */
+static void make_pattern(int pattern, int ways) {
+    double cdf[BENCH_MAX_WAYS];
+    double total = 0.0;
+    for (int w = 0; w < ways; w++) {
+        total += 1.0 / (w + 1);
+        cdf[w] = total;
+    }
+    int* next = (int*) calloc(bench_sets, sizeof(int));
+    srand(12345);
+    for (int i = 0; i < BENCH_PATTERN_LENGTH; i++) {
+        int set = rand() % bench_sets;
+        int w = 0;
+        if (pattern == 0) {
+            w = rand() % ways;
+        } else if (pattern == 1) {
+            w = next[set];
+            next[set] = (w + 1 == ways) ? 0 : w + 1;
+        } else {
+            double u = total * rand() / ((double) RAND_MAX + 1.0);
+            while (w < ways - 1 && cdf[w] <= u) {
+                w++;
+            }
+        }
+        pattern_sets[i] = set;
+        pattern_ways[i] = w;
+    }
+    free(next);
+}
+
+/**
+ * Function to set up the state of implementation <impl> for <bench_sets> sets of <ways>.
+ */
+static void bench_init(int impl, int ways) {
+    if (impl == 0) {
+        stacks = (lru_stack_t*) malloc(sizeof(lru_stack_t) * bench_sets);
+        int* ranks = (int*) malloc(sizeof(int) * bench_sets * ways);
+        for (int s = 0; s < bench_sets; s++) {
+            lru_stack_init_at(&stacks[s], ways, &ranks[(size_t) s * ways]);
+        }
+    } else if (impl == 1) {
+        fa.ways = ways;
+        fa.links = (fa_link_t*) malloc(sizeof(fa_link_t) * bench_sets * ways);
+        fa.lists = (fa_list_t*) malloc(sizeof(fa_list_t) * bench_sets);
+        for (int s = 0; s < bench_sets; s++) {
+            fa_init_set(&fa, s);
+        }
+    } else {
+        policy_kind = POLICY_SRRIP;
+        blocks = (cache_block_t*) calloc((size_t) bench_sets * ways, sizeof(cache_block_t));
+        for (size_t i = 0; i < (size_t) bench_sets * ways; i++) {
+            rrip_fill(&blocks[i], 0);
+        }
+    }
+}
+
+/**
+ * Function to free the state of implementation <impl>.
+ */
+static void bench_cleanup(int impl) {
+    if (impl == 0) {
+        free(stacks[0].indicies);
+        free(stacks);
+    } else if (impl == 1) {
+        free(fa.links);
+        free(fa.lists);
+    } else {
+        free(blocks);
+    }
+}
+
+/**
+ * Function to run <ops> operations of implementation <impl> on the current pattern.
+ * An operation marks a way MRU and asks for the LRU way. SRRIP has no LRU way, so its
+ * operation is a hit on the way, then a victim search and the fill that would follow.
+ */
+static void bench_run(int impl, int ways, long ops) {
+    int acc = 0;
+    for (long n = 0, i = 0; n < ops; n++, i = (i + 1 == BENCH_PATTERN_LENGTH) ? 0 : i + 1) {
+        int set = pattern_sets[i], w = pattern_ways[i];
+        if (impl == 0) {
+            lru_stack_set_mru(&stacks[set], w);
+            acc += lru_stack_get_lru(&stacks[set]);
+        } else if (impl == 1) {
+            fa_touch(&fa, set, w);
+            acc += fa.lists[set].tail;
+        } else {
+            cache_block_t* b = &blocks[(size_t) set * ways];
+            rrip_hit(&b[w]);
+            int v = rrip_victim(b, ways);
+            rrip_fill(&b[v], 0);
+            acc += v;
+        }
+    }
+    sink = acc;
+}
+
+/**
+ * Function to open a counter of cache event <config> for this thread.
+ *
+ * @return the counter, or -1 if perf_event_open is not available
+ */
+static int open_counter(unsigned type, unsigned long long config) {
+#ifdef __linux__
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int) syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#else
+    (void) type;
+    (void) config;
+    return -1;
+#endif
+}
+
+/**
+ * Function to reset and start, or stop, counter <fd>.
+ */
+static void counter_enable(int fd, int on) {
+#ifdef __linux__
+    if (fd >= 0) {
+        if (on) {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        }
+        ioctl(fd, on ? PERF_EVENT_IOC_ENABLE : PERF_EVENT_IOC_DISABLE, 0);
+    }
+#else
+    (void) fd;
+    (void) on;
+#endif
+}
+
+/**
+ * Function to format the value of counter <fd> per operation into <buf>.
+ */
+static void counter_per_op(int fd, long ops, char* buf, size_t len) {
+    unsigned long long value;
+    if (fd < 0 || read(fd, &value, sizeof(value)) != (ssize_t) sizeof(value)) {
+        snprintf(buf, len, "n/a");
+    } else {
+        snprintf(buf, len, "%.4f", (double) value / ops);
+    }
+}
+
+/**
+ * Function to time every implementation on every pattern at 2 to 64 ways. Each run
+ * replays the pattern once untimed, so the state is in the caches it fits in, then
+ * <ops> operations timed.
+ */
+void run_benchmarks(long ops) {
+    int l1d = -1, llc = -1;
+#ifdef __linux__
+    l1d = open_counter(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D
+                       | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+    llc = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+#endif
+    if (l1d < 0 && llc < 0) {
+        printf("perf_event_open is not available, cache misses are not counted\n");
+    }
+    printf("%-10s %-7s %5s %9s %14s %14s\n", "impl", "pattern", "ways", "ns/op", "L1D miss/op", "LLC miss/op");
+    for (int impl = 0; impl < 3; impl++) {
+        for (int pattern = 0; pattern < 3; pattern++) {
+            for (int ways = 2; ways <= BENCH_MAX_WAYS; ways *= 2) {
+                make_pattern(pattern, ways);
+                bench_init(impl, ways);
+                bench_run(impl, ways, BENCH_PATTERN_LENGTH);
+                struct timespec start, end;
+                counter_enable(l1d, 1);
+                counter_enable(llc, 1);
+                clock_gettime(CLOCK_MONOTONIC, &start);
+                bench_run(impl, ways, ops);
+                clock_gettime(CLOCK_MONOTONIC, &end);
+                counter_enable(l1d, 0);
+                counter_enable(llc, 0);
+                double ns = (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+                char l1d_buf[32], llc_buf[32];
+                counter_per_op(l1d, ops, l1d_buf, sizeof(l1d_buf));
+                counter_per_op(llc, ops, llc_buf, sizeof(llc_buf));
+                printf("%-10s %-7s %5d %9.2f %14s %14s\n", impl_names[impl], pattern_names[pattern],
+                       ways, ns / ops, l1d_buf, llc_buf);
+                bench_cleanup(impl);
+            }
+        }
+    }
+    if (l1d >= 0) {
+        close(l1d);
+    }
+    if (llc >= 0) {
+        close(llc);
+    }
+}
+
+static struct option long_options[] = {
+    {"bench", no_argument, 0, 'b'},
+    {"ops", required_argument, 0, 'o'},
+    {"sets", required_argument, 0, 's'},
+    {0, 0, 0, 0}
+};
+
+int main(int argc, char** argv) {
+    int bench = 0;
+    long ops = BENCH_DEFAULT_OPS;
+    int opt;
+    while ((opt = getopt_long(argc, argv, "", long_options, NULL)) != -1) {
+        switch (opt) {
+        case 'b':
+            bench = 1;
+            break;
+        case 'o':
+            ops = atol(optarg);
+            break;
+        case 's':
+            bench_sets = atoi(optarg);
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [--bench [--ops=n] [--sets=n]]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (bench) {
+        if (ops < 1 || bench_sets < 1) {
+            fprintf(stderr, "--ops and --sets must be at least 1\n");
+            return 1;
+        }
+        run_benchmarks(ops);
+        return 0;
+    }
     printf("------- Running TA tests -------\n");
     run_ta_tests();
     printf("------- Running Student tests -------\n");
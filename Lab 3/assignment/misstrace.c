@@ -0,0 +1,96 @@
+/**
+ * @author ECE 3058 TAs
+ */
+
+ #include <stdio.h>
+ #include "cachesim.h"
+ #include "misstrace.h"
+
+ #define MISSTRACE_BUFFER (1 << 20)  // stdio buffer, so records go out in large writes
+
+ misstrace_counter_t misstrace_fills = 0;
+ misstrace_counter_t misstrace_writebacks = 0;
+ static misstrace_counter_t warmup_records = 0;     // Records written before the last reset
+
+ static FILE* out = NULL;
+ static const char* out_path;
+
+ /**
+  * Function to create the miss trace file <path>.
+  *
+  * @param path is the file to create or overwrite
+  * @return 0 on success, -1 on error
+  */
+ int misstrace_open(const char* path) {
+     out = fopen(path, "w");
+     if (!out) {
+         perror("Unable to create miss trace");
+         return -1;
+     }
+     setvbuf(out, NULL, _IOFBF, MISSTRACE_BUFFER);
+     out_path = path;
+     return 0;
+ }
+
+ /**
+  * Function to write one record to the miss trace.
+  *
+  * @param type is the access type (MEMREAD, MEMWRITE or IFETCH)
+  * @param addr is the block-aligned address
+  * @param pc is the instruction address of the access that caused the record
+  * @param index is the index of that access in the original trace
+  */
+ void misstrace_emit(int type, unsigned long long addr, unsigned long long pc, unsigned long long index) {
+     fprintf(out, "%d\t%08llx\t%llx\t%llu\n", type, addr, pc, index);
+     if (type == MEMWRITE) {
+         misstrace_writebacks++;
+     } else {
+         misstrace_fills++;
+     }
+ }
+
+ /**
+  * Function to reset the record counts, e.g. at the end of the warm-up window. The
+  * records already written stay in the file.
+  */
+ void misstrace_reset_stats() {
+     warmup_records += misstrace_fills + misstrace_writebacks;
+     misstrace_fills = 0;
+     misstrace_writebacks = 0;
+ }
+
+ /**
+  * Function to print the number of records written and the filter ratio, i.e. the
+  * fraction of the accesses that reach the next level. Both count from the last reset,
+  * like <accesses>; records written before it are reported on their own.
+  *
+  * @param accesses is the number of accesses the records were filtered from
+  */
+ void misstrace_print_stats(unsigned long long accesses) {
+     misstrace_counter_t records = misstrace_fills + misstrace_writebacks;
+     printf("miss trace: %llu misses and %llu writebacks written to %s", misstrace_fills, misstrace_writebacks,
+            out_path);
+     if (warmup_records) {
+         printf(" (and %llu records during the warm-up)", warmup_records);
+     }
+     printf(", %llu of %llu records kept (filter ratio %.4f%%)\n", records, accesses,
+            accesses ? 100.0 * records / accesses : 0.0);
+ }
+
+ /**
+  * Function to flush and close the miss trace.
+  *
+  * @return 0 on success, -1 on error
+  */
+ int misstrace_close() {
+     if (!out) {
+         return 0;
+     }
+     int ret = fclose(out);
+     out = NULL;
+     if (ret != 0) {
+         perror("Unable to write miss trace");
+         return -1;
+     }
+     return 0;
+ }
@@ -0,0 +1,64 @@
+/**
+ * @author ECE 3058 TAs
+ */
+
+#ifndef __MISSTRACE_H
+#define __MISSTRACE_H
+
+/**
+ * This file contains the miss trace writer. With --miss-trace the simulated cache acts
+ * as a fixed L1 and everything it sends to the next level is written out as a trace:
+ * a read (or instruction fetch) of the missing block for every miss and a write of
+ * the victim block for every writeback. Studies of the lower levels can then replay
+ * the much shorter miss trace instead of the full one.
+ *
+ * The miss trace uses the usual text format (type, address, instruction address,
+ * tab separated) with a fourth column holding the index of the access in the
+ * original trace that caused the record. The simulator reads traces with or without
+ * that column, and a filtered trace filtered again keeps the original indices.
+ */
+
+typedef unsigned long long misstrace_counter_t;
+
+extern misstrace_counter_t misstrace_fills;       // Miss records written
+extern misstrace_counter_t misstrace_writebacks;  // Writeback records written
+
+/**
+ * Function to create the miss trace file <path>.
+ *
+ * @return 0 on success, -1 on error
+ */
+int misstrace_open(const char* path);
+
+/**
+ * Function to write one record to the miss trace.
+ *
+ * @param type is the access type (MEMREAD, MEMWRITE or IFETCH)
+ * @param addr is the block-aligned address
+ * @param pc is the instruction address of the access that caused the record
+ * @param index is the index of that access in the original trace
+ */
+void misstrace_emit(int type, unsigned long long addr, unsigned long long pc, unsigned long long index);
+
+/**
+ * Function to reset the record counts, e.g. at the end of the warm-up window. The
+ * records already written stay in the file.
+ */
+void misstrace_reset_stats(void);
+
+/**
+ * Function to print the number of records written and the filter ratio, both counted
+ * from the last reset.
+ *
+ * @param accesses is the number of accesses the records were filtered from
+ */
+void misstrace_print_stats(unsigned long long accesses);
+
+/**
+ * Function to flush and close the miss trace.
+ *
+ * @return 0 on success, -1 on error
+ */
+int misstrace_close(void);
+
+#endif
@@ -0,0 +1,193 @@
+/**
+ * @author ECE 3058 TAs
+ */
+
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include "nuca.h"
+
+ int nuca_kind = NUCA_NONE;
+ nuca_config_t nuca_config = { 4, 4, 2, 4, 0, 2 };
+ int nuca_group_ways = 1;
+ int* nuca_column_banks = NULL;
+ int* nuca_latency = NULL;
+ int* nuca_miss_latency = NULL;
+ nuca_counter_t* nuca_bank_hits = NULL;
+ nuca_counter_t* nuca_bank_fills = NULL;
+ nuca_counter_t nuca_hit_cycles = 0;
+ nuca_counter_t nuca_miss_cycles = 0;
+ nuca_counter_t nuca_migrations = 0;
+ nuca_counter_t nuca_moved_blocks = 0;
+
+ /**
+  * Function to apply a --nuca specification: "static" or "dynamic", followed by comma
+  * separated key=value settings on top of the defaults.
+  *
+  * @param spec is the option argument
+  * @return 0 on success, -1 on error
+  */
+ int nuca_parse(const char* spec) {
+     char buf[256];
+     if (strlen(spec) >= sizeof(buf)) {
+         fprintf(stderr, "--nuca specification too long\n");
+         return -1;
+     }
+     strcpy(buf, spec);
+     struct { const char* key; int* value; } keys[] = {
+         { "rows", &nuca_config.rows }, { "cols", &nuca_config.cols },
+         { "hop", &nuca_config.hop }, { "bank", &nuca_config.bank },
+         { "core_row", &nuca_config.core_row }, { "core_col", &nuca_config.core_col },
+     };
+     int core_col_set = 0;
+     char* item = strtok(buf, ",");
+     if (!item || (strcmp(item, "static") != 0 && strcmp(item, "dynamic") != 0)) {
+         fprintf(stderr, "Expected --nuca=static or --nuca=dynamic, then any settings\n");
+         return -1;
+     }
+     nuca_kind = (strcmp(item, "static") == 0) ? NUCA_STATIC : NUCA_DYNAMIC;
+     for (item = strtok(NULL, ","); item; item = strtok(NULL, ",")) {
+         char* value = strchr(item, '=');
+         if (!value) {
+             fprintf(stderr, "Expected key=value in --nuca, got %s\n", item);
+             return -1;
+         }
+         *value++ = '\0';
+         int found = 0;
+         for (int i = 0; i < (int) (sizeof(keys) / sizeof(keys[0])); i++) {
+             if (strcmp(item, keys[i].key) == 0) {
+                 *keys[i].value = atoi(value);
+                 found = 1;
+             }
+         }
+         if (!found) {
+             fprintf(stderr, "Unknown --nuca setting: %s\n", item);
+             return -1;
+         }
+         core_col_set |= (strcmp(item, "core_col") == 0);
+     }
+     // The requester sits in the middle of the top edge unless placed elsewhere
+     if (!core_col_set) {
+         nuca_config.core_col = nuca_config.cols / 2;
+     }
+     return 0;
+ }
+
+ /**
+  * Function to get the hops from the requester's router to bank <b>.
+  */
+ static int hops_to(int b) {
+     int r = b / nuca_config.cols, c = b % nuca_config.cols;
+     return abs(r - nuca_config.core_row) + abs(c - nuca_config.core_col);
+ }
+
+ /**
+  * Function to check the configuration against the geometry and set up the banks. In
+  * dynamic mode the banks of every column are ordered by distance, closest first, and
+  * way group <g> of a set lives in the <g>th of them.
+  *
+  * @param ways is the associativity
+  * @return 0 on success, -1 on error
+  */
+ int nuca_init(int ways) {
+     nuca_config_t* c = &nuca_config;
+     if (c->rows < 1 || c->cols < 1 || c->hop < 0 || c->bank < 0 || c->core_row < 0
+         || c->core_row >= c->rows || c->core_col < 0 || c->core_col >= c->cols) {
+         fprintf(stderr, "The NUCA mesh needs a row and a column, non-negative latencies and"
+                         " the requester on it\n");
+         return -1;
+     }
+     if (nuca_kind == NUCA_DYNAMIC && ways % c->rows != 0) {
+         fprintf(stderr, "--nuca=dynamic needs the ways to be a multiple of the %d rows\n", c->rows);
+         return -1;
+     }
+     int banks = c->rows * c->cols;
+     nuca_group_ways = ways / c->rows;
+     nuca_latency = (int*) malloc(sizeof(int) * banks);
+     nuca_column_banks = (int*) malloc(sizeof(int) * banks);
+     nuca_miss_latency = (int*) calloc(c->cols, sizeof(int));
+     nuca_bank_hits = (nuca_counter_t*) calloc(banks, sizeof(nuca_counter_t));
+     nuca_bank_fills = (nuca_counter_t*) calloc(banks, sizeof(nuca_counter_t));
+     if (!nuca_latency || !nuca_column_banks || !nuca_miss_latency || !nuca_bank_hits || !nuca_bank_fills) {
+         fprintf(stderr, "Unable to allocate the NUCA banks\n");
+         return -1;
+     }
+     for (int b = 0; b < banks; b++) {
+         nuca_latency[b] = c->bank + 2 * c->hop * hops_to(b);
+     }
+     for (int col = 0; col < c->cols; col++) {
+         int* order = &nuca_column_banks[col * c->rows];
+         for (int r = 0; r < c->rows; r++) {
+             // Insertion sort by latency, ties kept in row order
+             int b = r * c->cols + col, i = r;
+             while (i > 0 && nuca_latency[order[i - 1]] > nuca_latency[b]) {
+                 order[i] = order[i - 1];
+                 i--;
+             }
+             order[i] = b;
+         }
+         nuca_miss_latency[col] = nuca_latency[order[c->rows - 1]];
+     }
+     return 0;
+ }
+
+ /**
+  * Function to reset the statistics.
+  */
+ void nuca_reset_stats() {
+     int banks = nuca_config.rows * nuca_config.cols;
+     memset(nuca_bank_hits, 0, sizeof(nuca_counter_t) * banks);
+     memset(nuca_bank_fills, 0, sizeof(nuca_counter_t) * banks);
+     nuca_hit_cycles = 0;
+     nuca_miss_cycles = 0;
+     nuca_migrations = 0;
+     nuca_moved_blocks = 0;
+ }
+
+ /**
+  * Function to print the mesh, the average hit and miss latency, the migration traffic
+  * and the share of the lookups every bank served, a hit there or a fill into it, laid
+  * out like the mesh.
+  *
+  * @param block_size is the block size, to give the migration traffic in bytes
+  */
+ void nuca_print_stats(int block_size) {
+     nuca_config_t* c = &nuca_config;
+     int banks = c->rows * c->cols;
+     nuca_counter_t hits = 0, fills = 0;
+     for (int b = 0; b < banks; b++) {
+         hits += nuca_bank_hits[b];
+         fills += nuca_bank_fills[b];
+     }
+     printf("nuca: %s, %dx%d mesh, %d cycles per hop, %d cycle banks, requester at %d:%d\n",
+            nuca_kind == NUCA_STATIC ? "static" : "dynamic", c->rows, c->cols, c->hop, c->bank,
+            c->core_row, c->core_col);
+     printf("nuca: average hit latency %.2f cycles, miss lookup %.2f cycles, %llu migrations"
+            " moving %llu blocks (%llu bytes)\n",
+            hits ? (double) nuca_hit_cycles / hits : 0.0, fills ? (double) nuca_miss_cycles / fills : 0.0,
+            nuca_migrations, nuca_moved_blocks, nuca_moved_blocks * (nuca_counter_t) block_size);
+     for (int r = 0; r < c->rows; r++) {
+         printf("nuca: row %d lookups", r);
+         for (int col = 0; col < c->cols; col++) {
+             int b = r * c->cols + col;
+             printf(" %7.3f%%", hits + fills ? 100.0 * (nuca_bank_hits[b] + nuca_bank_fills[b]) / (hits + fills) : 0.0);
+         }
+         printf("\n");
+     }
+ }
+
+ /**
+  * Function to free the banks.
+  */
+ void nuca_cleanup() {
+     free(nuca_latency);
+     free(nuca_column_banks);
+     free(nuca_miss_latency);
+     free(nuca_bank_hits);
+     free(nuca_bank_fills);
+     nuca_latency = NULL;
+     nuca_column_banks = NULL;
+     nuca_miss_latency = NULL;
+     nuca_bank_hits = NULL;
+     nuca_bank_fills = NULL;
+ }
@@ -0,0 +1,124 @@
+/**
+ * @author ECE 3058 TAs
+ */
+
+#ifndef __NUCA_H
+#define __NUCA_H
+
+/**
+ * This file contains the NUCA latency model. With --nuca the cache is a last-level
+ * cache split into banks on a <rows> x <cols> mesh, and a lookup costs the bank access
+ * plus <hop> cycles per mesh hop from the requester's router to the bank and back:
+ *  - static (S-NUCA): the sets are interleaved over the banks by address, so every
+ *  block has one bank and its latency never changes
+ *  - dynamic (D-NUCA, Kim, Burger and Keckler, ASPLOS '02): every column of the mesh
+ *  is a bank set holding the sets interleaved over the columns, and the ways of a set
+ *  are spread over the banks of its column, the closest bank holding the first ways.
+ *  A hit moves the block one bank closer, swapping it with the LRU block of that bank,
+ *  so hot blocks drift towards the requester. Misses fill the farthest bank, evicting
+ *  its LRU block, and a lookup searches every bank of the column at once, so a miss is
+ *  known once the farthest bank answers.
+ *
+ * NOTES:
+ *      - Only hit latency and lookups are modeled, not contention in the banks or mesh.
+ *      - Dynamic mode needs LRU, a set-associative index function without the hashed
+ *      lookup, and a multiple of <rows> ways. The repeat filter is off with --nuca so
+ *      that every hit is charged to its bank.
+ *      - The bank counters are not part of a checkpoint, so --nuca cannot be combined
+ *      with --checkpoint or --restore.
+ */
+
+#define NUCA_NONE 0
+#define NUCA_STATIC 1
+#define NUCA_DYNAMIC 2
+
+typedef unsigned long long nuca_counter_t;
+
+/**
+ * Mesh and timing, set with --nuca=static|dynamic,key=value,...
+ */
+typedef struct nuca_config_t {
+    int rows;
+    int cols;
+    int hop;                // Cycles per hop, each way
+    int bank;               // Cycles of a bank access
+    int core_row;           // Router the requester is attached to
+    int core_col;
+} nuca_config_t;
+
+extern int nuca_kind;                   // Selected mode, NUCA_*
+extern nuca_config_t nuca_config;
+extern int nuca_group_ways;             // Ways per bank in dynamic mode
+extern int* nuca_column_banks;          // [column][group] bank of each way group, closest first
+extern int* nuca_latency;               // [bank] round trip cycles
+extern int* nuca_miss_latency;          // [column] cycles to rule out every bank of the column
+extern nuca_counter_t* nuca_bank_hits;  // [bank]
+extern nuca_counter_t* nuca_bank_fills; // [bank]
+extern nuca_counter_t nuca_hit_cycles;
+extern nuca_counter_t nuca_miss_cycles;
+extern nuca_counter_t nuca_migrations;  // Hits that moved a block closer
+extern nuca_counter_t nuca_moved_blocks; // Blocks those moves carried between banks
+
+/**
+ * Function to get the bank holding way <way> of set <set>.
+ */
+static inline int nuca_bank(int set, int way) {
+    if (nuca_kind == NUCA_STATIC) {
+        return set % (nuca_config.rows * nuca_config.cols);
+    }
+    return nuca_column_banks[(set % nuca_config.cols) * nuca_config.rows + way / nuca_group_ways];
+}
+
+/**
+ * Function to charge a hit in way <way> of set <set>.
+ */
+static inline void nuca_hit(int set, int way) {
+    int b = nuca_bank(set, way);
+    nuca_bank_hits[b]++;
+    nuca_hit_cycles += nuca_latency[b];
+}
+
+/**
+ * Function to charge a miss of set <set> that fills way <way>.
+ */
+static inline void nuca_miss(int set, int way) {
+    int b = nuca_bank(set, way);
+    nuca_bank_fills[b]++;
+    nuca_miss_cycles += (nuca_kind == NUCA_STATIC) ? nuca_latency[b] : nuca_miss_latency[set % nuca_config.cols];
+}
+
+/**
+ * Function to apply a --nuca specification: "static" or "dynamic", followed by comma
+ * separated key=value settings (rows, cols, hop, bank, core_row, core_col).
+ *
+ * @return 0 on success, -1 on error
+ */
+int nuca_parse(const char* spec);
+
+/**
+ * Function to check the configuration against the geometry and set up the banks.
+ *
+ * @param ways is the associativity
+ * @return 0 on success, -1 on error
+ */
+int nuca_init(int ways);
+
+/**
+ * Function to reset the statistics.
+ */
+void nuca_reset_stats(void);
+
+/**
+ * Function to print the mesh, the average hit and miss latency, the migration traffic
+ * and the share of the lookups every bank served.
+ *
+ * @param block_size is the block size, to give the migration traffic in bytes
+ */
+void nuca_print_stats(int block_size);
+
+/**
+ * Function to free the banks.
+ */
+void nuca_cleanup(void);
+
+#endif
@@ -0,0 +1,258 @@
+/**
+ * @author ECE 3058 TAs
+ */
+
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include "pagemap.h"
+
+ #define PAGEMAP_INITIAL_BITS 12    // log2 of the initial page map slots
+
+ int pagemap_kind = PAGEMAP_NONE;
+ int pagemap_page_bits = 12;
+ pagemap_tc_entry_t pagemap_tc[PAGEMAP_TC_ENTRIES];
+ pagemap_counter_t pagemap_lookups = 0;
+ pagemap_counter_t pagemap_tc_misses = 0;
+
+ static const char* pagemap_names[] = { "none", "sequential", "random", "binhop", "color" };
+
+ // Page map: open-addressing hash (linear probing) from virtual page to frame
+ static unsigned long long* map_keys;   // Virtual page number + 1 of each slot, 0 when empty
+ static unsigned long long* map_frames; // Frame of each slot
+ static int map_bits;                   // log2 of the slots
+ static unsigned long long map_used;    // Pages mapped
+
+ static unsigned long long num_frames;  // Frames of physical memory
+ static unsigned long long num_colors;  // Page colors
+ static unsigned long long next_frame;  // Next frame for sequential, pages placed for random
+ static unsigned long long* color_next; // Next frame of each color, as frame / num_colors
+ static unsigned* random_frames;        // Lazy Fisher-Yates shuffle of the frames, frame + 1 or 0 if untouched
+ static unsigned long long rng_state = 0x9E3779B97F4A7C15ULL;
+ static pagemap_counter_t shared_pages; // Pages given a frame already in use
+
+ /**
+  * Function to convert a policy name into a PAGEMAP_* value.
+  *
+  * @param name is the name given on the command line
+  * @return the PAGEMAP_* value, or -1 if the name is unknown
+  */
+ int pagemap_parse(const char* name) {
+     for (int i = 0; i < (int) (sizeof(pagemap_names) / sizeof(pagemap_names[0])); i++) {
+         if (strcmp(name, pagemap_names[i]) == 0) {
+             return i;
+         }
+     }
+     return -1;
+ }
+
+ /**
+  * Function to get the printable name of a PAGEMAP_* value.
+  *
+  * @param kind is the policy
+  * @return the name of the policy
+  */
+ const char* pagemap_name(int kind) {
+     return pagemap_names[kind];
+ }
+
+ /**
+  * Function to set up the page map.
+  *
+  * @param kind is the placement policy, PAGEMAP_*
+  * @param page_size is the page size in bytes, a power of 2
+  * @param phys_mem is the physical memory in bytes, a multiple of the page size
+  * @param colors is the number of page colors
+  * @return 0 on success, -1 on error
+  */
+ int pagemap_init(int kind, long long page_size, long long phys_mem, long long colors) {
+     pagemap_kind = kind;
+     pagemap_page_bits = 0;
+     while ((1LL << pagemap_page_bits) < page_size) {
+         pagemap_page_bits++;
+     }
+     num_frames = (unsigned long long) (phys_mem / page_size);
+     num_colors = (unsigned long long) colors;
+     if (num_frames < num_colors) {
+         fprintf(stderr, "Physical memory must hold at least one frame of each of the %llu page colors\n",
+                 num_colors);
+         return -1;
+     }
+     if (kind == PAGEMAP_RANDOM && num_frames >= 0xFFFFFFFFULL) {
+         fprintf(stderr, "--page-map=random supports at most 2^32 - 1 frames\n");
+         return -1;
+     }
+     memset(pagemap_tc, 0xFF, sizeof(pagemap_tc));
+     map_bits = PAGEMAP_INITIAL_BITS;
+     map_keys = (unsigned long long*) calloc(1ULL << map_bits, sizeof(unsigned long long));
+     map_frames = (unsigned long long*) malloc(sizeof(unsigned long long) << map_bits);
+     color_next = (unsigned long long*) calloc(num_colors, sizeof(unsigned long long));
+     if (kind == PAGEMAP_RANDOM) {
+         // calloc'd memory is only backed once the shuffle reaches it
+         random_frames = (unsigned*) calloc(num_frames, sizeof(unsigned));
+     }
+     if (!map_keys || !map_frames || !color_next || (kind == PAGEMAP_RANDOM && !random_frames)) {
+         fprintf(stderr, "Unable to allocate the page map\n");
+         return -1;
+     }
+     return 0;
+ }
+
+ /**
+  * Function to get the home slot of virtual page <vpn>.
+  */
+ static inline unsigned long long home_slot(unsigned long long vpn) {
+     return (vpn * 0x9E3779B97F4A7C15ULL) >> (64 - map_bits);
+ }
+
+ /**
+  * Function to double the page map.
+  */
+ static void grow_map() {
+     unsigned long long old_slots = 1ULL << map_bits;
+     unsigned long long* old_keys = map_keys;
+     unsigned long long* old_frames = map_frames;
+     map_bits++;
+     map_keys = (unsigned long long*) calloc(1ULL << map_bits, sizeof(unsigned long long));
+     map_frames = (unsigned long long*) malloc(sizeof(unsigned long long) << map_bits);
+     if (!map_keys || !map_frames) {
+         fprintf(stderr, "Unable to grow the page map\n");
+         exit(1);
+     }
+     unsigned long long mask = (1ULL << map_bits) - 1;
+     for (unsigned long long i = 0; i < old_slots; i++) {
+         if (old_keys[i] != 0) {
+             unsigned long long j = home_slot(old_keys[i] - 1);
+             while (map_keys[j] != 0) {
+                 j = (j + 1) & mask;
+             }
+             map_keys[j] = old_keys[i];
+             map_frames[j] = old_frames[i];
+         }
+     }
+     free(old_keys);
+     free(old_frames);
+ }
+
+ /**
+  * Function to get the next pseudo-random number (xorshift64*).
+  */
+ static inline unsigned long long next_random() {
+     rng_state ^= rng_state >> 12;
+     rng_state ^= rng_state << 25;
+     rng_state ^= rng_state >> 27;
+     return rng_state * 0x2545F4914F6CDD1DULL;
+ }
+
+ /**
+  * Function to take the next frame of <color>, wrapping around to frames already in
+  * use once all of its frames are taken.
+  */
+ static unsigned long long take_colored(unsigned long long color) {
+     unsigned long long per_color = num_frames / num_colors;
+     unsigned long long k = color_next[color]++;
+     if (k >= per_color) {
+         shared_pages++;
+         k %= per_color;
+     }
+     return color + k * num_colors;
+ }
+
+ /**
+  * Function to place a page that was never touched before.
+  *
+  * @param vpn is its virtual page number
+  * @return the frame it gets
+  */
+ static unsigned long long place_page(unsigned long long vpn) {
+     unsigned long long i;
+     switch (pagemap_kind) {
+     case PAGEMAP_RANDOM:
+         // Step <i> of a Fisher-Yates shuffle picks a random frame from the ones not
+         // taken yet and swaps it into position i. Untouched positions hold their own frame.
+         i = next_frame++;
+         if (i >= num_frames) {
+             shared_pages++;
+             i %= num_frames;
+         } else {
+             unsigned long long j = i + next_random() % (num_frames - i);
+             unsigned fi = random_frames[i] ? random_frames[i] : (unsigned) (i + 1);
+             random_frames[i] = random_frames[j] ? random_frames[j] : (unsigned) (j + 1);
+             random_frames[j] = fi;
+         }
+         return random_frames[i] - 1;
+     case PAGEMAP_BINHOP:
+         // Colors are handed out round robin, in the order the pages are first touched
+         return take_colored(map_used % num_colors);
+     case PAGEMAP_COLOR:
+         return take_colored(vpn % num_colors);
+     default:
+         i = next_frame++;
+         if (i >= num_frames) {
+             shared_pages++;
+             i %= num_frames;
+         }
+         return i;
+     }
+ }
+
+ /**
+  * Function to look up or create the frame of virtual page <vpn> in the page map and
+  * put the translation into the translation cache.
+  *
+  * @param vpn is the virtual page number
+  * @return the frame number
+  */
+ unsigned long long pagemap_walk(unsigned long long vpn) {
+     pagemap_tc_misses++;
+     unsigned long long mask = (1ULL << map_bits) - 1;
+     unsigned long long i = home_slot(vpn);
+     while (map_keys[i] != 0 && map_keys[i] != vpn + 1) {
+         i = (i + 1) & mask;
+     }
+     unsigned long long frame;
+     if (map_keys[i] != 0) {
+         frame = map_frames[i];
+     } else {
+         frame = place_page(vpn);
+         map_keys[i] = vpn + 1;
+         map_frames[i] = frame;
+         map_used++;
+         if (map_used * 2 > mask + 1) {
+             grow_map();
+         }
+     }
+     pagemap_tc_entry_t* e = &pagemap_tc[vpn & (PAGEMAP_TC_ENTRIES - 1)];
+     e->vpn = vpn;
+     e->frame = frame;
+     return frame;
+ }
+
+ /**
+  * Function to print the placement policy, the miss rate it led to, the pages mapped
+  * and the translation cache hit rate.
+  *
+  * @param accesses is the number of accesses
+  * @param misses is the number of misses
+  */
+ void pagemap_print_stats(unsigned long long accesses, unsigned long long misses) {
+     printf("page map: %s, %lld-byte pages, %llu colors, miss rate %.4f%%, %llu of %llu frames used"
+            " (%llu pages sharing a frame), translation cache hit rate %.4f%%\n",
+            pagemap_names[pagemap_kind], 1LL << pagemap_page_bits, num_colors,
+            accesses ? 100.0 * misses / accesses : 0.0, map_used - shared_pages, num_frames,
+            shared_pages, pagemap_lookups ? 100.0 * (pagemap_lookups - pagemap_tc_misses) / pagemap_lookups : 0.0);
+ }
+
+ /**
+  * Function to free the page map.
+  */
+ void pagemap_cleanup() {
+     free(map_keys);
+     free(map_frames);
+     free(color_next);
+     free(random_frames);
+     map_keys = NULL;
+     map_frames = NULL;
+     color_next = NULL;
+     random_frames = NULL;
+ }
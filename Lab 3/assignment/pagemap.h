@@ -0,0 +1,118 @@
+/**
+ * @author ECE 3058 TAs
+ */
+
+#ifndef __PAGEMAP_H
+#define __PAGEMAP_H
+
+#include "cachesim.h"
+
+/**
+ * This file contains the virtual-to-physical translation layer. Trace addresses are
+ * normally taken as physical, so a physically indexed cache sees the conflicts of the
+ * virtual layout. With --page-map each trace address is instead taken as virtual: a
+ * page is given a physical frame the first time it is touched, by one of the OS page
+ * placement policies below, and the cache sees the address in that frame.
+ *  - sequential: frames in the order pages are first touched
+ *  - random: a random free frame, like an allocator with no placement policy
+ *  - binhop: bin hopping (Kessler and Hill, TOCS '92), cycling through the page colors
+ *  in the order pages are first touched
+ *  - color: page coloring, the frame has the same color as the virtual page, so the
+ *  set index bits above the page offset are the virtual ones
+ *
+ * The color of a frame is the part of its number that lands in the set index, so there
+ * are (sets * block size) / page size colors, or one if a way fits in a page.
+ *
+ * NOTES:
+ *      - The page map is a hash from virtual page to frame. A direct-mapped translation
+ *      cache in front of it serves nearly every access with one compare.
+ *      - Once every frame is used, pages are given frames that are already in use, so
+ *      two pages share the blocks of one frame. The report counts these pages.
+ *      - The random policy uses a fixed seed, so runs are repeatable.
+ *      - The page map is not part of the cache state arena, so it cannot be combined
+ *      with checkpoints.
+ */
+
+#define PAGEMAP_NONE 0
+#define PAGEMAP_SEQUENTIAL 1
+#define PAGEMAP_RANDOM 2
+#define PAGEMAP_BINHOP 3
+#define PAGEMAP_COLOR 4
+
+#define PAGEMAP_DEFAULT_PAGE_SIZE 4096
+#define PAGEMAP_TC_ENTRIES 1024     // Translation cache entries, power of 2
+
+typedef unsigned long long pagemap_counter_t;
+
+/**
+ * One translation cache entry.
+ */
+typedef struct pagemap_tc_entry_t {
+    unsigned long long vpn;         // Virtual page number, ~0 when empty
+    unsigned long long frame;       // Its physical frame number
+} pagemap_tc_entry_t;
+
+extern int pagemap_kind;                        // Selected policy, PAGEMAP_*
+extern int pagemap_page_bits;                   // log2 of the page size
+extern pagemap_tc_entry_t pagemap_tc[PAGEMAP_TC_ENTRIES];
+extern pagemap_counter_t pagemap_lookups;       // Addresses translated
+extern pagemap_counter_t pagemap_tc_misses;     // ...that missed the translation cache
+
+/**
+ * Function to look up or create the frame of virtual page <vpn> in the page map and
+ * put the translation into the translation cache.
+ *
+ * @return the frame number
+ */
+unsigned long long pagemap_walk(unsigned long long vpn);
+
+/**
+ * Function to translate the virtual address <vaddr> into the physical address the
+ * cache sees.
+ */
+static inline unsigned long long pagemap_translate(unsigned long long vaddr) {
+    unsigned long long vpn = vaddr >> pagemap_page_bits;
+    pagemap_tc_entry_t* e = &pagemap_tc[vpn & (PAGEMAP_TC_ENTRIES - 1)];
+    pagemap_lookups++;
+    unsigned long long frame = (e->vpn == vpn) ? e->frame : pagemap_walk(vpn);
+    return (frame << pagemap_page_bits) | (vaddr & ((1ULL << pagemap_page_bits) - 1));
+}
+
+/**
+ * Function to get the policy named <name>.
+ *
+ * @return PAGEMAP_*, or -1 if there is no such policy
+ */
+int pagemap_parse(const char* name);
+
+/**
+ * Function to get the name of policy <kind>.
+ */
+const char* pagemap_name(int kind);
+
+/**
+ * Function to set up the page map.
+ *
+ * @param kind is the placement policy, PAGEMAP_*
+ * @param page_size is the page size in bytes, a power of 2
+ * @param phys_mem is the physical memory in bytes, a multiple of the page size
+ * @param colors is the number of page colors
+ * @return 0 on success, -1 on error
+ */
+int pagemap_init(int kind, long long page_size, long long phys_mem, long long colors);
+
+/**
+ * Function to print the placement policy, the miss rate it led to, the pages mapped
+ * and the translation cache hit rate.
+ *
+ * @param accesses is the number of accesses
+ * @param misses is the number of misses
+ */
+void pagemap_print_stats(unsigned long long accesses, unsigned long long misses);
+
+/**
+ * Function to free the page map.
+ */
+void pagemap_cleanup(void);
+
+#endif
@@ -0,0 +1,241 @@
+/**
+ * @author ECE 3058 TAs
+ */
+
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include "partition.h"
+
+ int partition_kind = PARTITION_NONE;
+ int partition_streams = 1;
+ int partition_stream = 0;
+ int partition_alloc[PARTITION_MAX_STREAMS];
+ stream_stats_t stream_stats[PARTITION_MAX_STREAMS];
+ stream_stats_t stream_baseline[PARTITION_MAX_STREAMS];
+ const char* stream_names[PARTITION_MAX_STREAMS];
+ partition_counter_t ucp_interval = UCP_DEFAULT_INTERVAL;
+ partition_counter_t ucp_countdown = UCP_DEFAULT_INTERVAL;
+ int umon_stride = 1;
+
+ static int static_count = 0;           // Allocations given on the command line
+ static int umon_ways;                  // Associativity of the shadow tags
+ static unsigned long long* umon_tags;  // [stream][sampled set][way] block addresses, MRU first
+ static int* umon_filled;               // [stream][sampled set] valid shadow tags
+ static partition_counter_t* umon_hits; // [stream][stack position] hits
+ static partition_counter_t repartitions = 0;
+
+ /**
+  * Function to parse --partition: "ucp", or a comma separated list of the ways of each
+  * stream.
+  *
+  * @param arg is the option argument
+  * @return PARTITION_STATIC or PARTITION_UCP, or -1 if <arg> is neither
+  */
+ int partition_parse(const char* arg) {
+     if (strcmp(arg, "ucp") == 0) {
+         return PARTITION_UCP;
+     }
+     static_count = 0;
+     const char* p = arg;
+     while (*p) {
+         char* end;
+         long w = strtol(p, &end, 10);
+         if (end == p || w < 1 || static_count == PARTITION_MAX_STREAMS || (*end != ',' && *end != '\0')) {
+             return -1;
+         }
+         partition_alloc[static_count++] = (int) w;
+         p = (*end == ',') ? end + 1 : end;
+     }
+     return static_count ? PARTITION_STATIC : -1;
+ }
+
+ /**
+  * Function to check the partitioning against the geometry and set up the UMONs.
+  *
+  * @param streams is the number of streams
+  * @param ways is the associativity
+  * @param sets is the number of sets
+  * @return 0 on success, -1 on error
+  */
+ int partition_init(int streams, int ways, int sets) {
+     partition_streams = streams;
+     if (partition_kind == PARTITION_NONE) {
+         return 0;
+     }
+     if (streams < 2 || streams > ways) {
+         fprintf(stderr, "Partitioning needs at least 2 streams (--mix) and at most one per way\n");
+         return -1;
+     }
+     if (partition_kind == PARTITION_STATIC) {
+         int total = 0;
+         for (int i = 0; i < static_count; i++) {
+             total += partition_alloc[i];
+         }
+         if (static_count != streams || total != ways) {
+             fprintf(stderr, "--partition must give each of the %d streams some of the %d ways\n",
+                     streams, ways);
+             return -1;
+         }
+         return 0;
+     }
+
+     // UCP starts out with the ways split evenly
+     for (int i = 0; i < streams; i++) {
+         partition_alloc[i] = ways / streams + (i < ways % streams);
+     }
+     umon_ways = ways;
+     umon_stride = (sets > UMON_SAMPLED_SETS) ? sets / UMON_SAMPLED_SETS : 1;
+     umon_tags = (unsigned long long*) malloc(sizeof(unsigned long long) * streams * UMON_SAMPLED_SETS * ways);
+     umon_filled = (int*) calloc((size_t) streams * UMON_SAMPLED_SETS, sizeof(int));
+     umon_hits = (partition_counter_t*) calloc((size_t) streams * ways, sizeof(partition_counter_t));
+     if (!umon_tags || !umon_filled || !umon_hits) {
+         fprintf(stderr, "Unable to allocate the utility monitors\n");
+         return -1;
+     }
+     ucp_countdown = ucp_interval;
+     return 0;
+ }
+
+ /**
+  * Function to update the UMON of <stream> with an access to <block> in sampled set <s>.
+  * The shadow tags are an LRU stack kept in MRU order, so the position of a hit is its
+  * stack distance.
+  *
+  * @param stream is the stream making the access
+  * @param s is the sampled set
+  * @param block is the block address
+  */
+ void umon_access(int stream, int s, unsigned long long block) {
+     int slot = stream * UMON_SAMPLED_SETS + s;
+     unsigned long long* stack = &umon_tags[(size_t) slot * umon_ways];
+     int n = umon_filled[slot];
+     int pos = 0;
+     while (pos < n && stack[pos] != block) {
+         pos++;
+     }
+     if (pos < n) {
+         umon_hits[(size_t) stream * umon_ways + pos]++;
+     } else if (n < umon_ways) {
+         umon_filled[slot] = n + 1;
+     } else {
+         pos = n - 1;
+     }
+     memmove(&stack[1], &stack[0], sizeof(unsigned long long) * pos);
+     stack[0] = block;
+ }
+
+ /**
+  * Function to reassign the ways with the lookahead algorithm and start a new interval.
+  * Each round finds, for every stream, the number of extra ways with the most hits per
+  * way, and gives those ways to the stream where that is highest.
+  */
+ void ucp_repartition() {
+     int balance = umon_ways - partition_streams;
+     for (int i = 0; i < partition_streams; i++) {
+         partition_alloc[i] = 1;
+     }
+     while (balance > 0) {
+         int best = 0, best_ways = 1;
+         double best_utility = -1.0;
+         for (int i = 0; i < partition_streams; i++) {
+             partition_counter_t* hits = &umon_hits[(size_t) i * umon_ways];
+             partition_counter_t gained = 0;
+             for (int k = 1; k <= balance; k++) {
+                 gained += hits[partition_alloc[i] + k - 1];
+                 double utility = (double) gained / k;
+                 if (utility > best_utility) {
+                     best = i;
+                     best_ways = k;
+                     best_utility = utility;
+                 }
+             }
+         }
+         partition_alloc[best] += best_ways;
+         balance -= best_ways;
+     }
+     for (size_t i = 0; i < (size_t) partition_streams * umon_ways; i++) {
+         umon_hits[i] /= 2;
+     }
+     repartitions++;
+     ucp_countdown = ucp_interval;
+ }
+
+ /**
+  * Function to find out which streams the current stream may evict from a full set,
+  * given the stream of each of its blocks. Since the allocations add up to the
+  * associativity, a stream below its allocation always finds another stream above its
+  * own.
+  *
+  * @param streams is the stream that filled each of the set's blocks
+  * @param ways is the associativity
+  * @param evictable is set to 1 for every stream whose blocks may be evicted
+  */
+ void partition_evictable(const unsigned char* streams, int ways, unsigned char* evictable) {
+     int held[PARTITION_MAX_STREAMS] = { 0 };
+     for (int w = 0; w < ways; w++) {
+         held[streams[w]]++;
+     }
+     memset(evictable, 0, PARTITION_MAX_STREAMS);
+     if (held[partition_stream] >= partition_alloc[partition_stream]) {
+         evictable[partition_stream] = 1;
+         return;
+     }
+     for (int i = 0; i < partition_streams; i++) {
+         evictable[i] = (held[i] > partition_alloc[i]);
+     }
+ }
+
+ /**
+  * Function to reset the statistics of every stream.
+  */
+ void partition_reset_stats() {
+     memset(stream_stats, 0, sizeof(stream_stats));
+ }
+
+ /**
+  * Function to get the hit rate of a stream.
+  */
+ static double hit_rate(const stream_stats_t* s) {
+     return s->accesses ? 100.0 * s->hits / s->accesses : 0.0;
+ }
+
+ /**
+  * Function to print the statistics of every stream and, when the cache is partitioned,
+  * the allocations and the gain over the unpartitioned run. The gain is in total hits,
+  * i.e. in accesses the next level no longer has to serve.
+  */
+ void partition_print_stats() {
+     partition_counter_t total = 0, baseline_total = 0;
+     for (int i = 0; i < partition_streams; i++) {
+         printf("stream %d (%s): %llu, %llu, %llu, %llu, hit rate %.4f%%", i, stream_names[i],
+                stream_stats[i].accesses, stream_stats[i].hits, stream_stats[i].misses,
+                stream_stats[i].writebacks, hit_rate(&stream_stats[i]));
+         if (partition_kind != PARTITION_NONE) {
+             printf(" (%.4f%% unpartitioned), %d ways", hit_rate(&stream_baseline[i]), partition_alloc[i]);
+             baseline_total += stream_baseline[i].hits;
+         }
+         printf("\n");
+         total += stream_stats[i].hits;
+     }
+     if (partition_kind != PARTITION_NONE) {
+         printf("partition: %s", partition_kind == PARTITION_UCP ? "ucp" : "static");
+         if (partition_kind == PARTITION_UCP) {
+             printf(" (%llu repartitions every %llu accesses)", repartitions, ucp_interval);
+         }
+         printf(", %llu hits vs %llu unpartitioned, gain %+.4f%%\n", total, baseline_total,
+                baseline_total ? 100.0 * ((double) total - (double) baseline_total) / baseline_total : 0.0);
+     }
+ }
+
+ /**
+  * Function to free the UMONs.
+  */
+ void partition_cleanup() {
+     free(umon_tags);
+     free(umon_filled);
+     free(umon_hits);
+     umon_tags = NULL;
+     umon_filled = NULL;
+     umon_hits = NULL;
+ }
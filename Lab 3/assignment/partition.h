@@ -0,0 +1,131 @@
+/**
+ * @author ECE 3058 TAs
+ */
+
+#ifndef __PARTITION_H
+#define __PARTITION_H
+
+#include "cachesim.h"
+
+/**
+ * This file contains shared-cache partitioning. With --mix the cache is shared by
+ * several trace streams (one per trace file, interleaved one access at a time), every
+ * block remembers the stream that filled it, and the cache can be partitioned by ways:
+ *  - static: each stream is given a fixed number of ways
+ *  - ucp: Utility-based Cache Partitioning (Qureshi and Patt, MICRO '06). A utility
+ *  monitor (UMON) per stream keeps shadow tags for a sample of the sets, as if the
+ *  stream had the whole cache to itself, and counts the hits at each LRU stack position.
+ *  Every interval the ways are reassigned by the lookahead algorithm, which keeps
+ *  giving ways to the stream whose hits grow the most per way, and the counters are
+ *  halved so older intervals count less.
+ *
+ * Allocations are enforced on replacement only. A stream below its allocation in a set
+ * evicts the LRU block of a stream above its own, and a stream at or above it evicts
+ * its own LRU block. Hits are never restricted.
+ *
+ * NOTES:
+ *      - Allocations always add up to the associativity and give every stream at least
+ *      one way.
+ *      - Only LRU with a set-associative index function is supported.
+ *      - The run without partitioning is simulated alongside in a child process, so the
+ *      report can compare every stream against the same accesses in a shared LRU cache.
+ */
+
+#define PARTITION_NONE 0
+#define PARTITION_STATIC 1
+#define PARTITION_UCP 2
+
+#define PARTITION_MAX_STREAMS 16
+#define UMON_SAMPLED_SETS 32            // Sets with shadow tags in each UMON
+#define UCP_DEFAULT_INTERVAL 1000000    // Accesses between repartitions
+
+typedef unsigned long long partition_counter_t;
+
+/**
+ * Statistics of one stream.
+ */
+typedef struct stream_stats_t {
+    partition_counter_t accesses;
+    partition_counter_t hits;
+    partition_counter_t misses;
+    partition_counter_t writebacks;     // Of blocks the stream's misses evicted
+} stream_stats_t;
+
+extern int partition_kind;                          // Selected partitioning, PARTITION_*
+extern int partition_streams;                       // Streams sharing the cache
+extern int partition_stream;                        // Stream making the current access
+extern int partition_alloc[PARTITION_MAX_STREAMS];  // Ways of each stream
+extern stream_stats_t stream_stats[PARTITION_MAX_STREAMS];
+extern stream_stats_t stream_baseline[PARTITION_MAX_STREAMS];  // ...of the unpartitioned run
+extern const char* stream_names[PARTITION_MAX_STREAMS];       // Trace file of each stream
+extern partition_counter_t ucp_interval;            // Accesses between repartitions
+extern partition_counter_t ucp_countdown;           // Accesses left in this interval
+extern int umon_stride;                             // Every stride-th set is sampled
+
+/**
+ * Function to update the UMON of <stream> with an access to <block> in sampled set <s>.
+ */
+void umon_access(int stream, int s, unsigned long long block);
+
+/**
+ * Function to reassign the ways with the lookahead algorithm and start a new interval.
+ */
+void ucp_repartition(void);
+
+/**
+ * Function to let UCP see an access of the current stream to <block> in <set>.
+ */
+static inline void ucp_observe(int set, unsigned long long block) {
+    if (set % umon_stride == 0 && set / umon_stride < UMON_SAMPLED_SETS) {
+        umon_access(partition_stream, set / umon_stride, block);
+    }
+    if (--ucp_countdown == 0) {
+        ucp_repartition();
+    }
+}
+
+/**
+ * Function to parse --partition: "ucp", or a comma separated list of the ways of each
+ * stream.
+ *
+ * @return PARTITION_STATIC or PARTITION_UCP, or -1 if <arg> is neither
+ */
+int partition_parse(const char* arg);
+
+/**
+ * Function to check the partitioning against the geometry and set up the UMONs.
+ *
+ * @param streams is the number of streams
+ * @param ways is the associativity
+ * @param sets is the number of sets
+ * @return 0 on success, -1 on error
+ */
+int partition_init(int streams, int ways, int sets);
+
+/**
+ * Function to find out which streams the current stream may evict from a full set,
+ * given the stream of each of its blocks.
+ *
+ * @param streams is the stream that filled each of the set's blocks
+ * @param ways is the associativity
+ * @param evictable is set to 1 for every stream whose blocks may be evicted
+ */
+void partition_evictable(const unsigned char* streams, int ways, unsigned char* evictable);
+
+/**
+ * Function to reset the statistics of every stream.
+ */
+void partition_reset_stats(void);
+
+/**
+ * Function to print the statistics of every stream and, when the cache is partitioned,
+ * the allocations and the gain over the unpartitioned run.
+ */
+void partition_print_stats(void);
+
+/**
+ * Function to free the UMONs.
+ */
+void partition_cleanup(void);
+
+#endif
@@ -0,0 +1,77 @@
+/**
+ * @author ECE 3058 TAs
+ */
+
+ #include <stdio.h>
+ #include <string.h>
+ #include "policy.h"
+
+ int policy_kind = POLICY_LRU;
+ unsigned char* ship_shct = NULL;
+ policy_counter_t ship_fills = 0;
+ policy_counter_t ship_dead_fills = 0;
+ policy_counter_t ship_dead_correct = 0;
+ policy_counter_t ship_dead_wrong = 0;
+ policy_counter_t ship_live_correct = 0;
+ policy_counter_t ship_live_wrong = 0;
+
+ static const char* policy_names[] = { "lru", "srrip", "ship" };
+
+ /**
+  * Function to convert a policy name into a POLICY_* value.
+  *
+  * @param name is the name given on the command line
+  * @return the POLICY_* value, or -1 if the name is unknown
+  */
+ int policy_parse(const char* name) {
+     for (int i = 0; i < (int) (sizeof(policy_names) / sizeof(policy_names[0])); i++) {
+         if (strcmp(name, policy_names[i]) == 0) {
+             return i;
+         }
+     }
+     return -1;
+ }
+
+ /**
+  * Function to get the printable name of a POLICY_* value.
+  *
+  * @param kind is the policy
+  * @return the name of the policy
+  */
+ const char* policy_name(int kind) {
+     return policy_names[kind];
+ }
+
+ /**
+  * Function to print the policy statistics: the miss rate and, for SHiP, how many fills
+  * were predicted dead and how often the predictions held by the time of eviction.
+  * Blocks still resident at the end have not been scored.
+  *
+  * @param accesses is the number of accesses
+  * @param misses is the number of misses
+  */
+ void policy_print_stats(unsigned long long accesses, unsigned long long misses) {
+     printf("policy: %s, miss rate %.4f%%\n", policy_names[policy_kind],
+            accesses ? 100.0 * misses / accesses : 0.0);
+     if (policy_kind != POLICY_SHIP) {
+         return;
+     }
+     policy_counter_t scored = ship_dead_correct + ship_dead_wrong + ship_live_correct + ship_live_wrong;
+     printf("ship: %llu of %llu fills predicted dead (%.4f%%), accuracy %.4f%% over %llu evictions"
+            " (dead %llu correct %llu wrong, live %llu correct %llu wrong)\n",
+            ship_dead_fills, ship_fills, ship_fills ? 100.0 * ship_dead_fills / ship_fills : 0.0,
+            scored ? 100.0 * (ship_dead_correct + ship_live_correct) / scored : 0.0, scored,
+            ship_dead_correct, ship_dead_wrong, ship_live_correct, ship_live_wrong);
+ }
+
+ /**
+  * Function to reset the policy statistics. The SHCT is kept.
+  */
+ void policy_reset_stats() {
+     ship_fills = 0;
+     ship_dead_fills = 0;
+     ship_dead_correct = 0;
+     ship_dead_wrong = 0;
+     ship_live_correct = 0;
+     ship_live_wrong = 0;
+ }
@@ -0,0 +1,174 @@
+/**
+ * @author ECE 3058 TAs
+ */
+
+#ifndef __POLICY_H
+#define __POLICY_H
+
+#include "cachesim.h"
+
+/**
+ * This file contains the replacement policies other than LRU:
+ *  - srrip: Static Re-Reference Interval Prediction (Jaleel et al., ISCA '10). Every
+ *  block has a 2-bit re-reference prediction value (RRPV). A hit sets it to 0, a fill
+ *  inserts at RRPV_LONG, and the victim is the first block at RRPV_MAX after aging the
+ *  whole set until one gets there.
+ *  - ship: Signature-based Hit Prediction (Wu et al., MICRO '11) on top of srrip. Each
+ *  fill is tagged with a signature hashed from the PC of the instruction that missed.
+ *  The Signature History Counter Table (SHCT) counts, per signature, whether its blocks
+ *  get reused: a hit increments the counter and an eviction without any reuse
+ *  decrements it. A fill whose counter is 0 is predicted dead and inserted at
+ *  RRPV_MAX, so it is the next victim unless it gets hit first.
+ *
+ * NOTES:
+ *      - The SHCT is part of the cache state arena, so checkpoints keep it trained.
+ *      - Only set-associative index functions are supported. The zcache walk of a
+ *      skewed cache compares timestamps across sets.
+ */
+
+#define POLICY_LRU 0
+#define POLICY_SRRIP 1
+#define POLICY_SHIP 2
+
+#define RRPV_MAX 3                  // Distant re-reference, next to be evicted
+#define RRPV_LONG 2                 // Where SRRIP inserts new blocks
+
+#define SHIP_SHCT_ENTRIES 16384     // Entries in the SHCT, power of 2
+#define SHIP_COUNTER_MAX 7          // 3-bit saturating counters
+#define SHIP_COUNTER_INIT 1         // Weakly reused, so a new signature starts out live
+
+// cache_block_t.flags
+#define BLOCK_REUSED 1              // Hit at least once since it was filled
+#define BLOCK_PREDICTED_DEAD 2      // SHiP inserted it at RRPV_MAX
+
+typedef unsigned long long policy_counter_t;
+
+extern int policy_kind;                     // Selected policy, POLICY_*
+extern unsigned char* ship_shct;            // SHCT, in the cache state arena
+extern policy_counter_t ship_fills;         // Fills seen by the predictor
+extern policy_counter_t ship_dead_fills;    // ...predicted dead
+extern policy_counter_t ship_dead_correct;  // Evictions of dead predictions never reused
+extern policy_counter_t ship_dead_wrong;    // ...that were reused anyway
+extern policy_counter_t ship_live_correct;  // Evictions of live predictions that were reused
+extern policy_counter_t ship_live_wrong;    // ...that never were
+
+/**
+ * Function to get the SHCT entry of the instruction at <pc>.
+ */
+static inline unsigned short ship_signature(unsigned long long pc) {
+    return (unsigned short) (((pc >> 2) ^ (pc >> 16)) & (SHIP_SHCT_ENTRIES - 1));
+}
+
+/**
+ * Function to apply a hit on <b>: it is predicted to be re-referenced soon, and under
+ * SHiP its signature is credited with a reuse.
+ */
+static inline void rrip_hit(cache_block_t* b) {
+    b->rrpv = 0;
+    if (policy_kind == POLICY_SHIP) {
+        b->flags |= BLOCK_REUSED;
+        if (ship_shct[b->signature] < SHIP_COUNTER_MAX) {
+            ship_shct[b->signature]++;
+        }
+    }
+}
+
+/**
+ * Function to pick the victim among <n> valid blocks: the first one at RRPV_MAX. When
+ * there is none the set is aged by the distance of the oldest block to RRPV_MAX, the
+ * same as incrementing every RRPV until one reaches it.
+ */
+static inline int rrip_victim(cache_block_t* blocks, int n) {
+    int victim = 0;
+    for (int w = 0; w < n; w++) {
+        if (blocks[w].rrpv >= RRPV_MAX) {
+            return w;
+        }
+        if (blocks[w].rrpv > blocks[victim].rrpv) {
+            victim = w;
+        }
+    }
+    int age = RRPV_MAX - blocks[victim].rrpv;
+    for (int w = 0; w < n; w++) {
+        blocks[w].rrpv += age;
+    }
+    return victim;
+}
+
+/**
+ * Function to train the SHCT with valid block <b> as it is evicted: a block that was
+ * never reused counts against its signature.
+ */
+static inline void ship_evict(cache_block_t* b) {
+    if (!(b->flags & BLOCK_REUSED) && ship_shct[b->signature] > 0) {
+        ship_shct[b->signature]--;
+    }
+}
+
+/**
+ * Function to score the prediction made for valid block <b> as it is evicted.
+ */
+static inline void ship_record(cache_block_t* b) {
+    int reused = (b->flags & BLOCK_REUSED) != 0;
+    if (b->flags & BLOCK_PREDICTED_DEAD) {
+        if (reused) {
+            ship_dead_wrong++;
+        } else {
+            ship_dead_correct++;
+        }
+    } else {
+        if (reused) {
+            ship_live_correct++;
+        } else {
+            ship_live_wrong++;
+        }
+    }
+}
+
+/**
+ * Function to set the replacement state of <b>, just filled by the instruction at <pc>.
+ *
+ * @return 1 if SHiP predicted the block dead, 0 otherwise
+ */
+static inline int rrip_fill(cache_block_t* b, unsigned long long pc) {
+    b->flags = 0;
+    b->rrpv = RRPV_LONG;
+    if (policy_kind == POLICY_SHIP) {
+        b->signature = ship_signature(pc);
+        if (ship_shct[b->signature] == 0) {
+            b->flags = BLOCK_PREDICTED_DEAD;
+            b->rrpv = RRPV_MAX;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Function to convert a policy name ("lru", "srrip", "ship") into a POLICY_* value.
+ *
+ * @param name is the name given on the command line
+ * @return the POLICY_* value, or -1 if the name is unknown
+ */
+int policy_parse(const char* name);
+
+/**
+ * Function to get the printable name of a POLICY_* value.
+ */
+const char* policy_name(int kind);
+
+/**
+ * Function to print the policy statistics: the miss rate and, for SHiP, how many fills
+ * were predicted dead and how often the predictions held by the time of eviction.
+ *
+ * @param accesses is the number of accesses
+ * @param misses is the number of misses
+ */
+void policy_print_stats(unsigned long long accesses, unsigned long long misses);
+
+/**
+ * Function to reset the policy statistics. The SHCT is kept.
+ */
+void policy_reset_stats(void);
+
+#endif
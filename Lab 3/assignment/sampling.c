@@ -0,0 +1,258 @@
+/**
+ * @author ECE 3058 TAs
+ */
+
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include "sampling.h"
+
+ /**
+  * Struct for a selected interval and, once simulated, its statistics.
+  */
+ typedef struct sample_t {
+     sample_counter_t n;             // Interval number
+     double weight;                  // Weight in the extrapolation
+     sample_counter_t accesses;
+     sample_counter_t misses;
+     sample_counter_t writebacks;
+ } sample_t;
+
+ static sample_counter_t interval_len;  // Accesses per interval
+ static sample_counter_t period;        // Detailed interval period, 0 when using a file
+ static sample_t* points = NULL;        // Intervals selected by the file, sorted
+ static int num_points = 0;
+ static sample_t* samples = NULL;       // Detailed intervals simulated so far
+ static int num_samples = 0;
+ static int samples_cap = 0;
+
+ // Results of the last extrapolation
+ static sample_counter_t total_intervals = 0;
+ static double miss_rate = 0, miss_rate_err = 0;
+ static double wb_rate = 0, wb_rate_err = 0;
+
+ /**
+  * Function to compute a square root with Newton's method, so the simulator does not
+  * need to link against libm.
+  */
+ static double sample_sqrt(double x) {
+     if (x <= 0) {
+         return 0;
+     }
+     double r = x > 1 ? x : 1;
+     for (int i = 0; i < 64; i++) {
+         r = 0.5 * (r + x / r);
+     }
+     return r;
+ }
+
+ static int compare_points(const void* a, const void* b) {
+     sample_counter_t x = ((const sample_t*) a)->n;
+     sample_counter_t y = ((const sample_t*) b)->n;
+     return (x > y) - (x < y);
+ }
+
+ /**
+  * Function to read the selected intervals from <path>. Each line has an interval
+  * number and an optional weight, which defaults to 1.
+  */
+ static int read_points(const char* path) {
+     FILE* in = fopen(path, "r");
+     if (!in) {
+         perror("Unable to open sample file");
+         return -1;
+     }
+     int cap = 64;
+     points = (sample_t*) malloc(sizeof(sample_t) * cap);
+     char buf[128];
+     while (fgets(buf, sizeof(buf), in)) {
+         unsigned long long n;
+         double weight = 1.0;
+         int ret = sscanf(buf, "%llu %lf", &n, &weight);
+         if (ret < 1) {
+             continue; // Blank line or comment
+         }
+         if (num_points == cap) {
+             cap *= 2;
+             points = (sample_t*) realloc(points, sizeof(sample_t) * cap);
+         }
+         points[num_points].n = n;
+         points[num_points].weight = weight;
+         num_points++;
+     }
+     fclose(in);
+     if (num_points == 0) {
+         fprintf(stderr, "%s does not select any intervals\n", path);
+         return -1;
+     }
+     qsort(points, num_points, sizeof(sample_t), compare_points);
+     return 0;
+ }
+
+ /**
+  * Function to find interval <n> in the selected intervals.
+  *
+  * @return the selected interval, or NULL if <n> is not selected
+  */
+ static sample_t* find_point(sample_counter_t n) {
+     int lo = 0, hi = num_points - 1;
+     while (lo <= hi) {
+         int mid = (lo + hi) / 2;
+         if (points[mid].n == n) {
+             return &points[mid];
+         } else if (points[mid].n < n) {
+             lo = mid + 1;
+         } else {
+             hi = mid - 1;
+         }
+     }
+     return NULL;
+ }
+
+ /**
+  * Function to set up sampling.
+  *
+  * @param interval is the number of accesses in each interval
+  * @param period selects every <period>th interval when <path> is NULL
+  * @param path is a file of interval numbers (from 0) and optional weights, or NULL
+  * @return 0 on success, -1 on error
+  */
+ int sampling_init(sample_counter_t interval, sample_counter_t _period, const char* path) {
+     interval_len = interval;
+     period = path ? 0 : _period;
+     if (interval_len == 0 || (!path && period == 0)) {
+         fprintf(stderr, "Sampling needs a non-zero interval length and period\n");
+         return -1;
+     }
+     return path ? read_points(path) : 0;
+ }
+
+ /**
+  * Function to check whether interval <n> is simulated in detail. With periodic
+  * sampling the last interval of each period is detailed, so every detailed interval
+  * follows <period> - 1 intervals of warming.
+  *
+  * @param n is the interval number, starting from 0
+  * @return 1 if the interval is simulated in detail, 0 if it is only warmed
+  */
+ int sampling_is_detailed(sample_counter_t n) {
+     if (period) {
+         return n % period == period - 1;
+     }
+     return find_point(n) != NULL;
+ }
+
+ /**
+  * Function to record the statistics of detailed interval <n>.
+  *
+  * @param n is the interval number
+  * @param accesses is the number of accesses in the interval
+  * @param misses is the number of misses in the interval
+  * @param writebacks is the number of writebacks in the interval
+  */
+ void sampling_record(sample_counter_t n, sample_counter_t accesses, sample_counter_t misses,
+                      sample_counter_t writebacks) {
+     if (accesses == 0) {
+         return;
+     }
+     if (num_samples == samples_cap) {
+         samples_cap = samples_cap ? samples_cap * 2 : 64;
+         samples = (sample_t*) realloc(samples, sizeof(sample_t) * samples_cap);
+     }
+     sample_t* s = &samples[num_samples++];
+     s->n = n;
+     s->weight = period ? 1.0 : find_point(n)->weight;
+     s->accesses = accesses;
+     s->misses = misses;
+     s->writebacks = writebacks;
+ }
+
+ /**
+  * Function to compute the weighted ratio estimate of a rate (events per access) and
+  * its standard error. Intervals count in proportion to their accesses, so a short
+  * final interval does not skew the estimate and detailing every interval gives the
+  * exact rate. The error shrinks by the finite population correction when intervals
+  * were picked periodically.
+  *
+  * @param wb selects the writeback rate instead of the miss rate
+  * @param err is set to the standard error
+  * @return the estimated rate
+  */
+ static double ratio_estimate(int wb, double* err) {
+     double events = 0, weighted_accesses = 0, var = 0;
+     for (int i = 0; i < num_samples; i++) {
+         events += samples[i].weight * (wb ? samples[i].writebacks : samples[i].misses);
+         weighted_accesses += samples[i].weight * samples[i].accesses;
+     }
+     double rate = events / weighted_accesses;
+     if (num_samples < 2) {
+         *err = 0;
+         return rate;
+     }
+     for (int i = 0; i < num_samples; i++) {
+         double e = (double) (wb ? samples[i].writebacks : samples[i].misses);
+         double d = samples[i].weight * (e - rate * samples[i].accesses);
+         var += d * d;
+     }
+     var *= (double) num_samples / (num_samples - 1) / (weighted_accesses * weighted_accesses);
+     if (period && total_intervals > (sample_counter_t) num_samples) {
+         var *= 1.0 - (double) num_samples / total_intervals;
+     }
+     *err = sample_sqrt(var);
+     return rate;
+ }
+
+ /**
+  * Function to extrapolate the whole-trace statistics from the recorded intervals.
+  *
+  * @param total_accesses is the number of accesses in the whole trace
+  * @param hits is set to the estimated number of hits
+  * @param misses is set to the estimated number of misses
+  * @param writebacks is set to the estimated number of writebacks
+  * @return 0 on success, -1 if no interval was simulated in detail
+  */
+ int sampling_estimate(sample_counter_t total_accesses, sample_counter_t* hits,
+                       sample_counter_t* misses, sample_counter_t* writebacks) {
+     total_intervals = (total_accesses + interval_len - 1) / interval_len;
+     if (num_samples == 0) {
+         if (period) {
+             fprintf(stderr, "No interval was simulated in detail: the trace has %llu intervals of %llu"
+                             " accesses, fewer than the period of %llu\n", total_intervals, interval_len, period);
+         } else {
+             fprintf(stderr, "No interval was simulated in detail: the trace has %llu intervals of %llu"
+                             " accesses and none of them is in the interval file\n", total_intervals, interval_len);
+         }
+         return -1;
+     }
+     miss_rate = ratio_estimate(0, &miss_rate_err);
+     wb_rate = ratio_estimate(1, &wb_rate_err);
+     *misses = (sample_counter_t) (miss_rate * total_accesses + 0.5);
+     *writebacks = (sample_counter_t) (wb_rate * total_accesses + 0.5);
+     *hits = total_accesses - *misses;
+     return 0;
+ }
+
+ /**
+  * Function to print the number of detailed intervals and the error estimates of the
+  * last extrapolation. One interval gives no estimate of the error, so it is n/a.
+  */
+ void sampling_print_stats() {
+     printf("sampling: %d of %llu intervals of %llu accesses in detail,", num_samples, total_intervals,
+            interval_len);
+     if (num_samples < 2) {
+         printf(" miss rate %.4f%% +/- n/a, writebacks/access %.4f%% +/- n/a\n", 100.0 * miss_rate,
+                100.0 * wb_rate);
+         return;
+     }
+     printf(" miss rate %.4f%% +/- %.4f%%, writebacks/access %.4f%% +/- %.4f%% (95%% CI)\n",
+            100.0 * miss_rate, 196.0 * miss_rate_err, 100.0 * wb_rate, 196.0 * wb_rate_err);
+ }
+
+ /**
+  * Function to free the sampling state.
+  */
+ void sampling_cleanup() {
+     free(points);
+     free(samples);
+     points = samples = NULL;
+     num_points = num_samples = samples_cap = 0;
+ }
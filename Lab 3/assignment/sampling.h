@@ -0,0 +1,75 @@
+/**
+ * @author ECE 3058 TAs
+ */
+
+#ifndef __SAMPLING_H
+#define __SAMPLING_H
+
+/**
+ * This file contains interval sampling. The trace is split into fixed-length
+ * intervals and only the selected intervals are simulated in detail. Every other
+ * access goes down the functional warming path (cachesim_warm), which keeps the tags,
+ * LRU state and dirty bits up to date but counts nothing, so the detailed intervals
+ * start from a warm cache.
+ *
+ * Intervals are selected either periodically (every <period>th interval) or from a
+ * file of interval numbers, one per line with an optional weight, such as the
+ * simulation points picked by SimPoint. The whole-trace statistics are extrapolated
+ * from the per-interval miss and writeback rates, with a 95% confidence interval.
+ */
+
+typedef unsigned long long sample_counter_t;
+
+/**
+ * Function to set up sampling.
+ *
+ * @param interval is the number of accesses in each interval
+ * @param period selects every <period>th interval when <path> is NULL
+ * @param path is a file of interval numbers (from 0) and optional weights, or NULL
+ * @return 0 on success, -1 on error
+ */
+int sampling_init(sample_counter_t interval, sample_counter_t period, const char* path);
+
+/**
+ * Function to check whether interval <n> is simulated in detail.
+ *
+ * @param n is the interval number, starting from 0
+ * @return 1 if the interval is simulated in detail, 0 if it is only warmed
+ */
+int sampling_is_detailed(sample_counter_t n);
+
+/**
+ * Function to record the statistics of detailed interval <n>.
+ *
+ * @param n is the interval number
+ * @param accesses is the number of accesses in the interval
+ * @param misses is the number of misses in the interval
+ * @param writebacks is the number of writebacks in the interval
+ */
+void sampling_record(sample_counter_t n, sample_counter_t accesses, sample_counter_t misses,
+                     sample_counter_t writebacks);
+
+/**
+ * Function to extrapolate the whole-trace statistics from the recorded intervals.
+ *
+ * @param total_accesses is the number of accesses in the whole trace
+ * @param hits is set to the estimated number of hits
+ * @param misses is set to the estimated number of misses
+ * @param writebacks is set to the estimated number of writebacks
+ * @return 0 on success, -1 if no interval was simulated in detail
+ */
+int sampling_estimate(sample_counter_t total_accesses, sample_counter_t* hits,
+                      sample_counter_t* misses, sample_counter_t* writebacks);
+
+/**
+ * Function to print the number of detailed intervals and the error estimates of the
+ * last extrapolation, n/a from a single interval.
+ */
+void sampling_print_stats(void);
+
+/**
+ * Function to free the sampling state.
+ */
+void sampling_cleanup(void);
+
+#endif
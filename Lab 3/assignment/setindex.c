@@ -0,0 +1,56 @@
+/**
+ * @author ECE 3058 TAs
+ */
+
+ #include <string.h>
+ #include "setindex.h"
+
+ static const char* index_names[] = { "bitslice", "xor", "prime", "skew", "mod" };
+
+ /**
+  * Function to find the largest prime that is <= n. Used to size the prime-modulo
+  * index function.
+  *
+  * @param n is the number of sets
+  * @return the largest prime <= n, or 1 if there is none
+  */
+ int index_largest_prime(int n) {
+     for (int p = n; p >= 2; p--) {
+         int prime = 1;
+         for (int d = 2; d * d <= p; d++) {
+             if (p % d == 0) {
+                 prime = 0;
+                 break;
+             }
+         }
+         if (prime) {
+             return p;
+         }
+     }
+     return 1;
+ }
+
+ /**
+  * Function to convert an index function name into one of the INDEX_* values.
+  *
+  * @param name is the name given on the command line
+  * @return the INDEX_* value, or -1 if the name is unknown
+  */
+ int index_parse(const char* name) {
+     for (int i = 0; i < (int) (sizeof(index_names) / sizeof(index_names[0])); i++) {
+         if (strcmp(name, index_names[i]) == 0) {
+             return i;
+         }
+     }
+     return -1;
+ }
+
+ /**
+  * Function to get the printable name of an INDEX_* value.
+  *
+  * @param fn is the index function
+  * @return the name of the function
+  */
+ const char* index_name(int fn) {
+     return index_names[fn];
+ }
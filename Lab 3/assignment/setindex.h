@@ -0,0 +1,145 @@
+/**
+ * @author ECE 3058 TAs
+ */
+
+#ifndef __SETINDEX_H
+#define __SETINDEX_H
+
+/**
+ * This file contains the set index functions the cache simulator can use to map a
+ * block address onto a set. The default is the plain bit slice used by real L1s;
+ * the others spread power-of-two strides over all the sets:
+ *  - xor:   XOR-folds every upper address bit onto the index bits
+ *  - prime: block address modulo the largest prime <= number of sets
+ *  - skew:  a different hash per way (skewed associativity). Lookups probe one
+ *           set per way and misses use zcache-style relocation to find a victim.
+ *  - mod:   block address modulo the number of sets, for set counts that are not a
+ *           power of 2 (bitslice switches to it for those). Same as bitslice otherwise.
+ *
+ * NOTES:
+ *      - All of the hashes are straight-line code so the per-access cost does not
+ *      depend on the address. The only branch is the selection of the function,
+ *      which is fixed for a whole run.
+ *      - Block addresses are the physical address (32 bits unless --addr-bits says
+ *      otherwise) shifted right by the number of offset bits, same as the rest of
+ *      the simulator.
+ *      - prime and mod divide with Lemire's fastmod (Lemire et al., "Faster
+ *      Remainder by Direct Computation", 2019): a precomputed 64-bit reciprocal turns
+ *      both the remainder and the quotient into multiplications.
+ */
+
+#define INDEX_BITSLICE 0
+#define INDEX_XOR 1
+#define INDEX_PRIME 2
+#define INDEX_SKEW 3
+#define INDEX_MODULO 4
+
+/**
+ * Struct for a 32-bit divisor and its precomputed reciprocal, ceil(2^64 / d).
+ */
+typedef struct fastmod_t {
+    unsigned long long m;
+    unsigned d;
+} fastmod_t;
+
+/**
+ * Function to precompute the reciprocal of <d>.
+ *
+ * @param d is the divisor, must be at least 2
+ */
+static inline fastmod_t fastmod_init(unsigned d) {
+    fastmod_t f;
+    f.m = ~0ULL / d + 1;
+    f.d = d;
+    return f;
+}
+
+/**
+ * Function to compute <a> mod <f.d>, exact for every 32-bit <a>.
+ */
+static inline unsigned fastmod_u32(unsigned a, fastmod_t f) {
+    unsigned long long low = f.m * a;
+    return (unsigned) (((unsigned __int128) low * f.d) >> 64);
+}
+
+/**
+ * Function to compute <a> / <f.d>, exact for every 32-bit <a>.
+ */
+static inline unsigned fastdiv_u32(unsigned a, fastmod_t f) {
+    return (unsigned) (((unsigned __int128) f.m * a) >> 64);
+}
+
+/**
+ * Function to compute <a> mod <f.d> for a block address of any width. Addresses above
+ * 32 bits are rare enough in a trace to go to the divider.
+ */
+static inline unsigned long long fastmod_u64(unsigned long long a, fastmod_t f) {
+    return (a >> 32) ? a % f.d : fastmod_u32((unsigned) a, f);
+}
+
+/**
+ * Function to compute <a> / <f.d> for a block address of any width.
+ */
+static inline unsigned long long fastdiv_u64(unsigned long long a, fastmod_t f) {
+    return (a >> 32) ? a / f.d : fastdiv_u32((unsigned) a, f);
+}
+
+/**
+ * Function to XOR-fold a block address onto <bits> index bits.
+ *
+ * @param block is the block address (address without offset bits)
+ * @param bits is the number of index bits, must be at least 1
+ * @return the set index
+ */
+static inline unsigned long long index_xor_fold(unsigned long long block, int bits) {
+    unsigned long long x = block;
+    for (int s = bits; s < 64; s += bits) {
+        x ^= block >> s;
+    }
+    return x & ((1ULL << bits) - 1);
+}
+
+/**
+ * Function to compute the set of <block> in way <way> of a skewed-associative cache.
+ * Every way uses its own odd multiplier, so two blocks that conflict in one way are
+ * very unlikely to conflict in another.
+ *
+ * @param block is the block address
+ * @param way is the way being indexed
+ * @param bits is the number of index bits
+ * @return the set index for that way
+ */
+static inline unsigned long long index_skew(unsigned long long block, int way, int bits) {
+    unsigned long long k = 0x9E3779B97F4A7C15ULL + (unsigned long long) way * 0xD6E8FEB86659FD93ULL;
+    unsigned long long h = (block ^ (block >> 17)) * (k | 1);
+    // Two shifts so that bits == 0 does not shift by 64
+    return (h >> (63 - bits)) >> 1;
+}
+
+/**
+ * Function to find the largest prime that is <= n. Used to size the prime-modulo
+ * index function.
+ *
+ * @param n is the number of sets
+ * @return the largest prime <= n, or 1 if there is none
+ */
+int index_largest_prime(int n);
+
+/**
+ * Function to convert an index function name ("bitslice", "xor", "prime", "skew", "mod")
+ * into one of the INDEX_* values.
+ *
+ * @param name is the name given on the command line
+ * @return the INDEX_* value, or -1 if the name is unknown
+ */
+int index_parse(const char* name);
+
+/**
+ * Function to get the printable name of an INDEX_* value.
+ *
+ * @param fn is the index function
+ * @return the name of the function
+ */
+const char* index_name(int fn);
+
+#endif
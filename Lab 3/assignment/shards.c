@@ -0,0 +1,342 @@
+/**
+ * @author ECE 3058 TAs
+ */
+
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include "shards.h"
+
+ // Reuse distance histogram: 16 linear buckets, then 16 buckets per power of 2
+ #define SHARDS_SUB 16
+ #define SHARDS_BUCKETS (SHARDS_SUB + 60 * SHARDS_SUB)
+
+ /**
+  * Struct for a sampled block in the hash table.
+  */
+ typedef struct shards_entry_t {
+     shards_addr_t block;
+     unsigned int time;      // Logical time of the last reference, a Fenwick tree index
+     int used;
+ } shards_entry_t;
+
+ /**
+  * Struct for a sampled block in the max-heap ordered by sampling hash.
+  */
+ typedef struct shards_heap_t {
+     unsigned long long hash;
+     shards_addr_t block;
+ } shards_heap_t;
+
+ unsigned long long shards_threshold = SHARDS_MODULUS;
+ unsigned long long shards_refs = 0;
+
+ static int max_samples;
+ static unsigned long long samples = 0;     // References to sampled blocks
+
+ static shards_entry_t* table;              // Sampled blocks, linear probing
+ static unsigned int table_mask;
+ static int table_bits;
+ static int num_blocks = 0;
+
+ static shards_heap_t* heap;                // Sampled blocks by hash, largest first
+ static int heap_size = 0;
+
+ static int* fenwick;                       // 1 at the last reference time of each block
+ static unsigned int time_cap;
+ static unsigned int next_time = 0;
+
+ static double hist[SHARDS_BUCKETS];        // Scaled reuse distance histogram
+ static double cold = 0;                    // First references (infinite distance)
+
+ /**
+  * Function to get the histogram bucket of scaled distance <v>.
+  */
+ static int bucket_of(unsigned long long v) {
+     if (v < SHARDS_SUB) {
+         return (int) v;
+     }
+     int e = 63 - __builtin_clzll(v);
+     return SHARDS_SUB + (e - 4) * SHARDS_SUB + (int) ((v >> (e - 4)) & (SHARDS_SUB - 1));
+ }
+
+ /**
+  * Function to get the smallest distance in histogram bucket <b>.
+  */
+ static unsigned long long bucket_lo(int b) {
+     if (b < SHARDS_SUB) {
+         return (unsigned long long) b;
+     }
+     int e = (b - SHARDS_SUB) / SHARDS_SUB + 4;
+     unsigned long long sub = (unsigned long long) ((b - SHARDS_SUB) % SHARDS_SUB);
+     return (SHARDS_SUB + sub) << (e - 4);
+ }
+
+ static void fenwick_add(unsigned int t, int delta) {
+     for (unsigned int i = t + 1; i <= time_cap; i += i & -i) {
+         fenwick[i] += delta;
+     }
+ }
+
+ /**
+  * Function to count the blocks whose last reference time is <= t.
+  */
+ static int fenwick_prefix(unsigned int t) {
+     int sum = 0;
+     for (unsigned int i = t + 1; i > 0; i -= i & -i) {
+         sum += fenwick[i];
+     }
+     return sum;
+ }
+
+ static unsigned int table_home(shards_addr_t block) {
+     return (unsigned int) ((block * 0x9E3779B97F4A7C15ULL) >> (64 - table_bits));
+ }
+
+ /**
+  * Function to find <block> in the hash table.
+  *
+  * @return its slot if present, otherwise the empty slot where it belongs
+  */
+ static unsigned int table_find(shards_addr_t block) {
+     unsigned int i = table_home(block);
+     while (table[i].used && table[i].block != block) {
+         i = (i + 1) & table_mask;
+     }
+     return i;
+ }
+
+ /**
+  * Function to delete slot <i> from the hash table, shifting later entries of the
+  * probe sequence back so lookups never need tombstones.
+  */
+ static void table_delete(unsigned int i) {
+     unsigned int j = i;
+     for (;;) {
+         j = (j + 1) & table_mask;
+         if (!table[j].used) {
+             break;
+         }
+         unsigned int k = table_home(table[j].block);
+         // Move j into the hole unless its home lies cyclically in (i, j]
+         int stays = (i <= j) ? (i < k && k <= j) : (i < k || k <= j);
+         if (!stays) {
+             table[i] = table[j];
+             i = j;
+         }
+     }
+     table[i].used = 0;
+     num_blocks--;
+ }
+
+ static void heap_push(unsigned long long hash, shards_addr_t block) {
+     int i = heap_size++;
+     while (i > 0 && heap[(i - 1) / 2].hash < hash) {
+         heap[i] = heap[(i - 1) / 2];
+         i = (i - 1) / 2;
+     }
+     heap[i].hash = hash;
+     heap[i].block = block;
+ }
+
+ static shards_heap_t heap_pop() {
+     shards_heap_t top = heap[0];
+     shards_heap_t last = heap[--heap_size];
+     int i = 0;
+     for (;;) {
+         int c = 2 * i + 1;
+         if (c >= heap_size) {
+             break;
+         }
+         if (c + 1 < heap_size && heap[c + 1].hash > heap[c].hash) {
+             c++;
+         }
+         if (heap[c].hash <= last.hash) {
+             break;
+         }
+         heap[i] = heap[c];
+         i = c;
+     }
+     heap[i] = last;
+     return top;
+ }
+
+ static int compare_times(const void* a, const void* b) {
+     unsigned int x = (*(shards_entry_t* const*) a)->time;
+     unsigned int y = (*(shards_entry_t* const*) b)->time;
+     return (x > y) - (x < y);
+ }
+
+ /**
+  * Function to renumber the reference times 0..n-1 in their current order once the
+  * Fenwick tree is full, so it never has to grow.
+  */
+ static void compact_times() {
+     shards_entry_t** live = (shards_entry_t**) malloc(sizeof(shards_entry_t*) * (num_blocks + 1));
+     int n = 0;
+     for (unsigned int i = 0; i <= table_mask; i++) {
+         if (table[i].used) {
+             live[n++] = &table[i];
+         }
+     }
+     qsort(live, n, sizeof(shards_entry_t*), compare_times);
+     memset(fenwick, 0, sizeof(int) * (time_cap + 1));
+     for (int i = 0; i < n; i++) {
+         live[i]->time = (unsigned int) i;
+         fenwick_add((unsigned int) i, 1);
+     }
+     next_time = (unsigned int) n;
+     free(live);
+ }
+
+ /**
+  * Function to drop the sampled blocks with the largest hash and lower the threshold
+  * to that hash. The histogram so far is rescaled to the new rate.
+  */
+ static void lower_threshold() {
+     unsigned long long new_threshold = heap[0].hash;
+     double scale = (double) new_threshold / shards_threshold;
+     for (int b = 0; b < SHARDS_BUCKETS; b++) {
+         hist[b] *= scale;
+     }
+     cold *= scale;
+     shards_threshold = new_threshold;
+
+     while (heap_size > 0 && heap[0].hash >= shards_threshold) {
+         shards_heap_t top = heap_pop();
+         unsigned int slot = table_find(top.block);
+         fenwick_add(table[slot].time, -1);
+         table_delete(slot);
+     }
+ }
+
+ /**
+  * Function to process a reference to a sampled block: measure its reuse distance
+  * among the sampled blocks, scale it by the sampling rate and count it.
+  */
+ void shards_sample(shards_addr_t block, unsigned long long hash) {
+     if (next_time == time_cap) {
+         compact_times();
+     }
+     samples++;
+     unsigned int now = next_time++;
+     unsigned int slot = table_find(block);
+     if (table[slot].used) {
+         unsigned int last = table[slot].time;
+         int distance = fenwick_prefix(now - 1) - fenwick_prefix(last);
+         double rate = (double) shards_threshold / SHARDS_MODULUS;
+         hist[bucket_of((unsigned long long) (distance / rate))] += 1;
+         fenwick_add(last, -1);
+     } else {
+         cold += 1;
+         table[slot].block = block;
+         table[slot].used = 1;
+         num_blocks++;
+         heap_push(hash, block);
+     }
+     table[slot].time = now;
+     fenwick_add(now, 1);
+
+     if (num_blocks > max_samples) {
+         lower_threshold();
+     }
+ }
+
+ /**
+  * Function to set up the MRC.
+  *
+  * @param rate is the initial sampling rate, 0 < rate <= 1
+  * @param _max_samples is the most distinct blocks to track at once
+  * @return 0 on success, -1 on error
+  */
+ int shards_init(double rate, int _max_samples) {
+     if (rate <= 0 || rate > 1 || _max_samples < 1) {
+         fprintf(stderr, "MRC sampling rate must be in (0, 1] and the sample bound positive\n");
+         return -1;
+     }
+     max_samples = _max_samples;
+     shards_threshold = (unsigned long long) (rate * SHARDS_MODULUS);
+     if (shards_threshold == 0) {
+         shards_threshold = 1;
+     }
+
+     // Hash table at most 1/4 full, room for 3 * max_samples references between compactions
+     table_bits = 2;
+     while ((1 << table_bits) < 4 * (max_samples + 1)) {
+         table_bits++;
+     }
+     table_mask = (1u << table_bits) - 1;
+     table = (shards_entry_t*) calloc(table_mask + 1, sizeof(shards_entry_t));
+     heap = (shards_heap_t*) malloc(sizeof(shards_heap_t) * (max_samples + 1));
+     time_cap = 4 * (unsigned int) (max_samples + 1);
+     fenwick = (int*) calloc(time_cap + 1, sizeof(int));
+     return 0;
+ }
+
+ /**
+  * Function to write the MRC as CSV: one line per cache size with the size in bytes
+  * and the estimated miss ratio.
+  *
+  * @param path is the CSV file to write
+  * @param block_size is the block size in bytes
+  * @return 0 on success, -1 on error
+  */
+ int shards_write_mrc(const char* path, int block_size) {
+     FILE* out = fopen(path, "w");
+     if (!out) {
+         perror("Unable to create MRC file");
+         return -1;
+     }
+
+     // SHARDS_adj: the difference between the references the final rate should have
+     // sampled and those the histogram accounts for is credited to (or taken from) the
+     // smallest distance. It works on a copy, so the histogram itself is left as is.
+     double adj[SHARDS_BUCKETS];
+     memcpy(adj, hist, sizeof(adj));
+     double total = cold;
+     int last = 0;
+     for (int b = 0; b < SHARDS_BUCKETS; b++) {
+         total += adj[b];
+         if (adj[b] > 0) {
+             last = b;
+         }
+     }
+     double expected = (double) shards_refs * shards_threshold / SHARDS_MODULUS;
+     double first = adj[0] + (expected - total);
+     first = (first > 0) ? first : 0;
+     total += first - adj[0];
+     adj[0] = first;
+
+     fprintf(out, "cache_size_bytes,miss_ratio\n");
+     double reused = 0;
+     for (int b = 1; b <= last + 1; b++) {
+         reused += adj[b - 1];
+         fprintf(out, "%llu,%.6f\n", bucket_lo(b) * (unsigned long long) block_size,
+                 total > 0 ? 1.0 - reused / total : 0.0);
+     }
+     if (fclose(out) != 0) {
+         perror("Unable to write MRC file");
+         return -1;
+     }
+     return 0;
+ }
+
+ /**
+  * Function to print the number of references seen and sampled and the final rate.
+  */
+ void shards_print_stats() {
+     printf("mrc: %llu references, %llu sampled, %d blocks tracked, final rate %.6f\n",
+            shards_refs, samples, num_blocks, (double) shards_threshold / SHARDS_MODULUS);
+ }
+
+ /**
+  * Function to free the MRC state.
+  */
+ void shards_cleanup() {
+     free(table);
+     free(heap);
+     free(fenwick);
+     table = NULL;
+     heap = NULL;
+     fenwick = NULL;
+ }
@@ -0,0 +1,92 @@
+/**
+ * @author ECE 3058 TAs
+ */
+
+#ifndef __SHARDS_H
+#define __SHARDS_H
+
+/**
+ * This file contains an approximate LRU miss ratio curve (MRC) built with SHARDS
+ * (Spatially Hashed Approximate Reuse Distance Sampling, Waldspurger et al., FAST '15).
+ *
+ * A block is sampled when hash(block) mod P < T, so every access to a sampled block
+ * is seen and reuse distances between sampled blocks stay exact, just scaled down by
+ * the sampling rate R = T / P. The fixed-size variant is used: at most <max_samples>
+ * distinct blocks are tracked, and when that is exceeded the blocks with the largest
+ * hash are dropped and T is lowered to match. Memory is therefore constant no matter
+ * how long the trace is or how many blocks it touches.
+ *
+ * NOTES:
+ *      - Distances are kept in a histogram with 16 log-spaced buckets per power of 2,
+ *      so the curve has a point roughly every 6% of cache size.
+ *      - The curve is for a fully associative LRU cache with the simulated block size.
+ */
+
+#define SHARDS_MODULUS (1ULL << 24)     // P, the hash space the threshold is taken from
+#define SHARDS_DEFAULT_SAMPLES 8192     // Default bound on the sampled blocks
+
+typedef unsigned long long shards_addr_t;
+
+extern unsigned long long shards_threshold;     // T, blocks hashing below it are sampled
+extern unsigned long long shards_refs;          // References fed to the MRC
+
+/**
+ * Function to hash a block address into the sampling space. This is the splitmix64
+ * finalizer, which spreads any address pattern evenly.
+ */
+static inline unsigned long long shards_hash(shards_addr_t block) {
+    unsigned long long x = block + 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return (x ^ (x >> 31)) & (SHARDS_MODULUS - 1);
+}
+
+/**
+ * Function to process a reference to a sampled block. Call through shards_access.
+ */
+void shards_sample(shards_addr_t block, unsigned long long hash);
+
+/**
+ * Function to feed one reference to the MRC. Most references are not sampled and
+ * cost one hash and one compare.
+ *
+ * @param block is the block address of the reference
+ */
+static inline void shards_access(shards_addr_t block) {
+    unsigned long long hash = shards_hash(block);
+    shards_refs++;
+    if (hash < shards_threshold) {
+        shards_sample(block, hash);
+    }
+}
+
+/**
+ * Function to set up the MRC.
+ *
+ * @param rate is the initial sampling rate, 0 < rate <= 1
+ * @param max_samples is the most distinct blocks to track at once
+ * @return 0 on success, -1 on error
+ */
+int shards_init(double rate, int max_samples);
+
+/**
+ * Function to write the MRC as CSV: one line per cache size with the size in bytes
+ * and the estimated miss ratio.
+ *
+ * @param path is the CSV file to write
+ * @param block_size is the block size in bytes
+ * @return 0 on success, -1 on error
+ */
+int shards_write_mrc(const char* path, int block_size);
+
+/**
+ * Function to print the number of references seen and sampled and the final rate.
+ */
+void shards_print_stats(void);
+
+/**
+ * Function to free the MRC state.
+ */
+void shards_cleanup(void);
+
+#endif
@@ -0,0 +1,107 @@
+/**
+ * @author ECE 3058 TAs
+ */
+
+#ifndef __TAGSTORE_H
+#define __TAGSTORE_H
+
+#include <string.h>
+
+/**
+ * This file contains the packed tag array. Tags are kept apart from the rest of the
+ * block state, in the narrowest of 16, 32, 48 or 64 bits that holds every tag the
+ * geometry can produce, so a cache of 64-bit addresses only pays for the tag bits it
+ * actually needs.
+ *
+ * NOTES:
+ *      - 48-bit tags are 6 bytes with no padding. They are read and written through
+ *      memcpy, which compiles to plain unaligned loads and stores.
+ *      - Whether a tag is valid is kept in the block state, the tag array has no
+ *      spare value to mark it.
+ */
+
+typedef unsigned long long tag_t;
+
+/**
+ * View of a tag array in the cache state arena.
+ */
+typedef struct tag_store_t {
+    unsigned char* base;    // Tag of line i is at base + i * bytes
+    int bytes;              // 2, 4, 6 or 8
+} tag_store_t;
+
+/**
+ * Function to get the tag width in bytes for tags of <bits> bits.
+ */
+static inline int tag_bytes_for(int bits) {
+    if (bits <= 16) {
+        return 2;
+    } else if (bits <= 32) {
+        return 4;
+    } else if (bits <= 48) {
+        return 6;
+    }
+    return 8;
+}
+
+/**
+ * Function to get the tag of line <i>.
+ */
+static inline tag_t tag_get(const tag_store_t* ts, size_t i) {
+    const unsigned char* p = ts->base + i * ts->bytes;
+    switch (ts->bytes) {
+    case 2: {
+        unsigned short t;
+        memcpy(&t, p, 2);
+        return t;
+    }
+    case 4: {
+        unsigned t;
+        memcpy(&t, p, 4);
+        return t;
+    }
+    case 6: {
+        unsigned lo;
+        unsigned short hi;
+        memcpy(&lo, p, 4);
+        memcpy(&hi, p + 4, 2);
+        return lo | ((tag_t) hi << 32);
+    }
+    default: {
+        tag_t t;
+        memcpy(&t, p, 8);
+        return t;
+    }
+    }
+}
+
+/**
+ * Function to set the tag of line <i> to <tag>, which must fit in the store's width.
+ */
+static inline void tag_put(tag_store_t* ts, size_t i, tag_t tag) {
+    unsigned char* p = ts->base + i * ts->bytes;
+    switch (ts->bytes) {
+    case 2: {
+        unsigned short t = (unsigned short) tag;
+        memcpy(p, &t, 2);
+        break;
+    }
+    case 4: {
+        unsigned t = (unsigned) tag;
+        memcpy(p, &t, 4);
+        break;
+    }
+    case 6: {
+        unsigned lo = (unsigned) tag;
+        unsigned short hi = (unsigned short) (tag >> 32);
+        memcpy(p, &lo, 4);
+        memcpy(p + 4, &hi, 2);
+        break;
+    }
+    default:
+        memcpy(p, &tag, 8);
+        break;
+    }
+}
+
+#endif
@@ -0,0 +1,143 @@
+/**
+ * @author ECE 3058 TAs
+ */
+
+ #include <stdio.h>
+ #include <string.h>
+ #include "timeseries.h"
+
+ #define TIMESERIES_BUFFER (1 << 20)  // stdio buffer, so records go out in large writes
+
+ timeseries_counts_t timeseries_current[3];
+ timeseries_counter_t timeseries_left = TIMESERIES_DEFAULT_LENGTH;
+ int timeseries_by_instructions = 0;
+
+ static FILE* out = NULL;
+ static const char* out_path;
+ static int out_format;
+ static timeseries_counter_t length;        // Accesses or instructions per interval
+ static timeseries_counter_t intervals = 0; // Intervals written
+ static timeseries_counter_t before_accesses = 0;      // Accesses before the current interval
+ static timeseries_counter_t before_instructions = 0;  // ...and instructions
+
+ static const char* type_names[] = { "read", "write", "ifetch" };
+
+ /**
+  * Function to parse the --timeseries-unit argument.
+  *
+  * @param arg is the option argument
+  * @return 1 for "instructions", 0 for "accesses", -1 for anything else
+  */
+ int timeseries_parse_unit(const char* arg) {
+     if (strcmp(arg, "instructions") == 0) {
+         return 1;
+     }
+     return (strcmp(arg, "accesses") == 0) ? 0 : -1;
+ }
+
+ /**
+  * Function to parse the --timeseries-format argument.
+  *
+  * @param arg is the option argument
+  * @return TIMESERIES_CSV or TIMESERIES_BINARY, or -1 if <arg> is neither
+  */
+ int timeseries_parse_format(const char* arg) {
+     if (strcmp(arg, "csv") == 0) {
+         return TIMESERIES_CSV;
+     }
+     return (strcmp(arg, "binary") == 0) ? TIMESERIES_BINARY : -1;
+ }
+
+ /**
+  * Function to create the time series file <path> and write the CSV header.
+  *
+  * @param path is the file to create or overwrite
+  * @param format is TIMESERIES_CSV or TIMESERIES_BINARY
+  * @param _length is the number of accesses, or instructions, per interval
+  * @param by_instructions is 1 to count instructions instead of accesses
+  * @return 0 on success, -1 on error
+  */
+ int timeseries_open(const char* path, int format, timeseries_counter_t _length, int by_instructions) {
+     out = fopen(path, "w");
+     if (!out) {
+         perror("Unable to create time series");
+         return -1;
+     }
+     setvbuf(out, NULL, _IOFBF, TIMESERIES_BUFFER);
+     out_path = path;
+     out_format = format;
+     length = _length;
+     timeseries_left = _length;
+     timeseries_by_instructions = by_instructions;
+     if (format == TIMESERIES_CSV) {
+         fprintf(out, "interval,first_access,first_instruction");
+         for (int t = 0; t < 3; t++) {
+             fprintf(out, ",%s_accesses,%s_hits,%s_misses,%s_writebacks",
+                     type_names[t], type_names[t], type_names[t], type_names[t]);
+         }
+         fprintf(out, "\n");
+     }
+     return 0;
+ }
+
+ /**
+  * Function to write the current interval out and start the next one. Only called
+  * once per interval, so the cost of formatting a record is spread over its accesses.
+  */
+ void timeseries_end_interval() {
+     timeseries_counter_t record[TIMESERIES_COLUMNS];
+     record[0] = intervals;
+     record[1] = before_accesses;
+     record[2] = before_instructions;
+     for (int t = 0; t < 3; t++) {
+         record[3 + 4 * t] = timeseries_current[t].accesses;
+         record[4 + 4 * t] = timeseries_current[t].hits;
+         record[5 + 4 * t] = timeseries_current[t].misses;
+         record[6 + 4 * t] = timeseries_current[t].writebacks;
+         before_accesses += timeseries_current[t].accesses;
+     }
+     before_instructions += timeseries_current[IFETCH].accesses;
+
+     if (out_format == TIMESERIES_BINARY) {
+         fwrite(record, sizeof(record), 1, out);
+     } else {
+         fprintf(out, "%llu", record[0]);
+         for (int i = 1; i < TIMESERIES_COLUMNS; i++) {
+             fprintf(out, ",%llu", record[i]);
+         }
+         fprintf(out, "\n");
+     }
+     memset(timeseries_current, 0, sizeof(timeseries_current));
+     intervals++;
+     timeseries_left = length;
+ }
+
+ /**
+  * Function to print the number of intervals written.
+  */
+ void timeseries_print_stats() {
+     printf("time series: %llu intervals of %llu %s written to %s\n", intervals, length,
+            timeseries_by_instructions ? "instructions" : "accesses", out_path);
+ }
+
+ /**
+  * Function to write the last, partial interval, then flush and close the file.
+  *
+  * @return 0 on success, -1 on error
+  */
+ int timeseries_close() {
+     if (!out) {
+         return 0;
+     }
+     if (timeseries_current[MEMREAD].accesses + timeseries_current[MEMWRITE].accesses
+         + timeseries_current[IFETCH].accesses > 0) {
+         timeseries_end_interval();
+     }
+     int ret = fclose(out);
+     out = NULL;
+     if (ret != 0) {
+         perror("Unable to write time series");
+         return -1;
+     }
+     return 0;
+ }
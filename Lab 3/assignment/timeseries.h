@@ -0,0 +1,115 @@
+/**
+ * @author ECE 3058 TAs
+ */
+
+#ifndef __TIMESERIES_H
+#define __TIMESERIES_H
+
+#include "cachesim.h"
+
+/**
+ * This file contains the interval time series. With --timeseries the run is cut into
+ * intervals of a fixed number of accesses, or of instructions (IFETCH accesses), and
+ * every interval's accesses, hits, misses and writebacks are written out split by
+ * access type, so phase changes that the totals average away can be found, e.g. to
+ * pick simulation points for --sample-file.
+ *
+ * Each interval is one record of 15 columns: the interval number, the accesses and
+ * the instructions before it, then accesses, hits, misses and writebacks of MEMREAD,
+ * MEMWRITE and IFETCH in that order. The csv format writes the records as text with a
+ * header line, the binary format as 15 unsigned 64-bit integers in host byte order.
+ * Either way the records go through a large stdio buffer, so the accesses themselves
+ * never make a system call.
+ *
+ * NOTES:
+ *      - A writeback is charged to the type of the access whose miss caused it.
+ *      - The last interval is usually partial. Intervals ignore --warmup.
+ *      - The interval counters are not part of a checkpoint, so --timeseries cannot be
+ *      combined with --checkpoint or --restore.
+ */
+
+#define TIMESERIES_DEFAULT_LENGTH 100000
+
+#define TIMESERIES_CSV 0
+#define TIMESERIES_BINARY 1
+
+#define TIMESERIES_COLUMNS 15
+
+typedef unsigned long long timeseries_counter_t;
+
+/**
+ * Statistics of one access type in the current interval.
+ */
+typedef struct timeseries_counts_t {
+    timeseries_counter_t accesses;
+    timeseries_counter_t hits;
+    timeseries_counter_t misses;
+    timeseries_counter_t writebacks;
+} timeseries_counts_t;
+
+extern timeseries_counts_t timeseries_current[3];  // Indexed by access type
+extern timeseries_counter_t timeseries_left;       // Accesses or instructions left in the interval
+extern int timeseries_by_instructions;             // 1 if intervals count IFETCH accesses only
+
+/**
+ * Function to write the current interval out and start the next one.
+ */
+void timeseries_end_interval(void);
+
+/**
+ * Function to count one access in the current interval.
+ *
+ * @param type is the access type (MEMREAD, MEMWRITE or IFETCH)
+ * @param hit is 1 if it hit
+ * @param miss is 1 if it missed
+ * @param writeback is 1 if it caused a writeback
+ */
+static inline void timeseries_account(int type, int hit, int miss, int writeback) {
+    int t = (type == MEMWRITE || type == IFETCH) ? type : MEMREAD;
+    timeseries_counts_t* c = &timeseries_current[t];
+    c->accesses++;
+    c->hits += hit;
+    c->misses += miss;
+    c->writebacks += writeback;
+    if ((t == IFETCH || !timeseries_by_instructions) && --timeseries_left == 0) {
+        timeseries_end_interval();
+    }
+}
+
+/**
+ * Function to parse the --timeseries-unit argument.
+ *
+ * @return 1 for "instructions", 0 for "accesses", -1 for anything else
+ */
+int timeseries_parse_unit(const char* arg);
+
+/**
+ * Function to parse the --timeseries-format argument.
+ *
+ * @return TIMESERIES_CSV or TIMESERIES_BINARY, or -1 if <arg> is neither
+ */
+int timeseries_parse_format(const char* arg);
+
+/**
+ * Function to create the time series file <path>.
+ *
+ * @param format is TIMESERIES_CSV or TIMESERIES_BINARY
+ * @param length is the number of accesses, or instructions, per interval
+ * @param by_instructions is 1 to count instructions instead of accesses
+ * @return 0 on success, -1 on error
+ */
+int timeseries_open(const char* path, int format, timeseries_counter_t length, int by_instructions);
+
+/**
+ * Function to print the number of intervals written.
+ */
+void timeseries_print_stats(void);
+
+/**
+ * Function to write the last, partial interval, then flush and close the file.
+ *
+ * @return 0 on success, -1 on error
+ */
+int timeseries_close(void);
+
+#endif
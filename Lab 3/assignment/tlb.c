@@ -0,0 +1,344 @@
+/**
+ * @author ECE 3058 TAs
+ */
+
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include "tlb.h"
+
+ int tlb_enabled = 0;
+ int tlb_policy = POLICY_LRU;
+ tlb_config_t tlb_config = {
+     { 128, 8 }, { 8, 8 }, { 64, 4 }, { 32, 4 }, { 1536, 12 }, 9, 25, 4096, 2 << 20, 0
+ };
+ int tlb_page_bits = 12;
+ int tlb_huge_bits = 21;
+ tlb_t tlb_l1[2][2];
+
+ static tlb_t stlb;
+ static int walk_levels[2];              // [huge] page table levels of a walk
+ static tlb_counter_t walks[2];          // [huge]
+ static tlb_counter_t translation_cycles = 0;
+
+ /**
+  * Function to read an entries[:ways] value into <g>.
+  *
+  * @return 0 on success, -1 if <value> is not a number
+  */
+ static int parse_geometry(const char* value, tlb_geometry_t* g) {
+     char* end;
+     g->entries = (int) strtol(value, &end, 10);
+     if (end == value) {
+         return -1;
+     }
+     if (*end == ':') {
+         value = end + 1;
+         g->ways = (int) strtol(value, &end, 10);
+         if (end == value) {
+             return -1;
+         }
+     }
+     return (*end == '\0') ? 0 : -1;
+ }
+
+ /**
+  * Function to apply a --tlb specification: the replacement policy, followed by comma
+  * separated key=value settings on top of the defaults.
+  *
+  * @param spec is the option argument
+  * @return 0 on success, -1 on error
+  */
+ int tlb_parse(const char* spec) {
+     char buf[256];
+     if (strlen(spec) >= sizeof(buf)) {
+         fprintf(stderr, "--tlb specification too long\n");
+         return -1;
+     }
+     strcpy(buf, spec);
+     struct { const char* key; tlb_geometry_t* value; } geometries[] = {
+         { "itlb", &tlb_config.itlb }, { "itlb_huge", &tlb_config.itlb_huge },
+         { "dtlb", &tlb_config.dtlb }, { "dtlb_huge", &tlb_config.dtlb_huge },
+         { "stlb", &tlb_config.stlb },
+     };
+     struct { const char* key; long long* value; } sizes[] = {
+         { "page", &tlb_config.page }, { "huge_page", &tlb_config.huge_page },
+     };
+     struct { const char* key; int* value; } ints[] = {
+         { "stlb_hit", &tlb_config.stlb_hit }, { "walk", &tlb_config.walk }, { "huge", &tlb_config.huge },
+     };
+     char* item = strtok(buf, ",");
+     tlb_policy = item ? policy_parse(item) : -1;
+     if (tlb_policy != POLICY_LRU && tlb_policy != POLICY_SRRIP) {
+         fprintf(stderr, "Expected --tlb=lru or --tlb=srrip, then any settings\n");
+         return -1;
+     }
+     for (item = strtok(NULL, ","); item; item = strtok(NULL, ",")) {
+         char* value = strchr(item, '=');
+         if (!value) {
+             fprintf(stderr, "Expected key=value in --tlb, got %s\n", item);
+             return -1;
+         }
+         *value++ = '\0';
+         int found = 0;
+         for (int i = 0; i < (int) (sizeof(geometries) / sizeof(geometries[0])); i++) {
+             if (strcmp(item, geometries[i].key) == 0) {
+                 if (parse_geometry(value, geometries[i].value) != 0) {
+                     fprintf(stderr, "Expected entries or entries:ways for --tlb %s, got %s\n", item, value);
+                     return -1;
+                 }
+                 found = 1;
+             }
+         }
+         for (int i = 0; i < (int) (sizeof(sizes) / sizeof(sizes[0])); i++) {
+             if (strcmp(item, sizes[i].key) == 0) {
+                 *sizes[i].value = atoll(value);
+                 found = 1;
+             }
+         }
+         for (int i = 0; i < (int) (sizeof(ints) / sizeof(ints[0])); i++) {
+             if (strcmp(item, ints[i].key) == 0) {
+                 *ints[i].value = atoi(value);
+                 found = 1;
+             }
+         }
+         if (!found) {
+             fprintf(stderr, "Unknown --tlb setting: %s\n", item);
+             return -1;
+         }
+     }
+     tlb_enabled = 1;
+     return 0;
+ }
+
+ /**
+  * Function to get log2 of <n>, or -1 if <n> is not a power of 2.
+  */
+ static int log2_exact(long long n) {
+     if (n < 1 || (n & (n - 1)) != 0) {
+         return -1;
+     }
+     int bits = 0;
+     while ((1LL << bits) < n) {
+         bits++;
+     }
+     return bits;
+ }
+
+ /**
+  * Function to allocate TLB array <t> of geometry <g>, every entry invalid.
+  *
+  * @return 0 on success, -1 on error
+  */
+ static int setup(tlb_t* t, const char* name, tlb_geometry_t g) {
+     if (g.entries < 1 || g.ways < 1 || g.entries % g.ways != 0 || log2_exact(g.entries / g.ways) < 0) {
+         fprintf(stderr, "The %s needs a power of 2 number of sets of <ways> entries, got %d:%d\n",
+                 name, g.entries, g.ways);
+         return -1;
+     }
+     t->name = name;
+     t->sets = g.entries / g.ways;
+     t->ways = g.ways;
+     t->tags = (addr_t*) calloc(g.entries, sizeof(addr_t));
+     t->state = (cache_block_t*) calloc(g.entries, sizeof(cache_block_t));
+     t->ranks = (int*) malloc(sizeof(int) * g.entries);
+     if (!t->tags || !t->state || !t->ranks) {
+         fprintf(stderr, "Unable to allocate the %s\n", name);
+         return -1;
+     }
+     for (int s = 0; s < t->sets; s++) {
+         lru_stack_t stack;
+         lru_stack_init_at(&stack, t->ways, &t->ranks[s * t->ways]);
+     }
+     t->last_tag = ~0ULL;
+     t->last = 0;
+     return 0;
+ }
+
+ /**
+  * Function to check the configuration and allocate the TLBs.
+  *
+  * @param addr_bits is the number of address bits simulated
+  * @return 0 on success, -1 on error
+  */
+ int tlb_init(int addr_bits) {
+     tlb_config_t* c = &tlb_config;
+     tlb_page_bits = log2_exact(c->page);
+     tlb_huge_bits = log2_exact(c->huge_page);
+     if (tlb_page_bits < 0 || tlb_huge_bits <= tlb_page_bits || tlb_huge_bits >= addr_bits) {
+         fprintf(stderr, "TLB pages must be powers of 2, with huge pages larger than base pages"
+                         " and smaller than the address space\n");
+         return -1;
+     }
+     if (c->huge < 0 || c->huge > 100 || c->stlb_hit < 0 || c->walk < 0) {
+         fprintf(stderr, "--tlb huge is a percentage and the latencies must not be negative\n");
+         return -1;
+     }
+     if (setup(&tlb_l1[TLB_ITLB][0], "itlb", c->itlb) != 0 || setup(&tlb_l1[TLB_ITLB][1], "itlb_huge", c->itlb_huge) != 0
+         || setup(&tlb_l1[TLB_DTLB][0], "dtlb", c->dtlb) != 0 || setup(&tlb_l1[TLB_DTLB][1], "dtlb_huge", c->dtlb_huge) != 0
+         || setup(&stlb, "stlb", c->stlb) != 0) {
+         return -1;
+     }
+     walk_levels[0] = (addr_bits - tlb_page_bits + TLB_LEVEL_BITS - 1) / TLB_LEVEL_BITS;
+     walk_levels[1] = (addr_bits - tlb_huge_bits + TLB_LEVEL_BITS - 1) / TLB_LEVEL_BITS;
+     return 0;
+ }
+
+ /**
+  * Function to mark entry <i> of <t> as just used.
+  */
+ static void touch(tlb_t* t, int i) {
+     if (tlb_policy == POLICY_LRU) {
+         int first = i - i % t->ways;
+         lru_stack_t stack = { t->ways, &t->ranks[first] };
+         lru_stack_set_mru(&stack, i - first);
+     } else {
+         t->state[i].rrpv = 0;
+     }
+     t->last_tag = t->tags[i];
+     t->last = i;
+ }
+
+ /**
+  * Function to look up <tag> in <t>, filling it on a miss.
+  *
+  * @return 1 on a hit, 0 on a miss
+  */
+ static int probe(tlb_t* t, addr_t tag) {
+     t->lookups++;
+     if (tag == t->last_tag) {
+         t->state[t->last].rrpv = 0;
+         return 1;
+     }
+     int first = (int) (tag & (addr_t) (t->sets - 1)) * t->ways;
+     cache_block_t* set = &t->state[first];
+     for (int w = 0; w < t->ways; w++) {
+         if (set[w].valid && t->tags[first + w] == tag) {
+             touch(t, first + w);
+             return 1;
+         }
+     }
+     t->misses++;
+
+     // Victim is the first invalid entry, otherwise the policy's choice
+     int victim = -1;
+     for (int w = 0; w < t->ways; w++) {
+         if (!set[w].valid) {
+             victim = w;
+             break;
+         }
+     }
+     if (victim < 0 && tlb_policy == POLICY_LRU) {
+         lru_stack_t stack = { t->ways, &t->ranks[first] };
+         victim = lru_stack_get_lru(&stack);
+     } else if (victim < 0) {
+         victim = rrip_victim(set, t->ways);
+     }
+     set[victim].valid = 1;
+     set[victim].rrpv = RRPV_LONG;
+     t->tags[first + victim] = tag;
+     if (tlb_policy == POLICY_LRU) {
+         touch(t, first + victim);
+     } else {
+         t->last_tag = tag;
+         t->last = first + victim;
+     }
+     return 0;
+ }
+
+ /**
+  * Function to find a translation in <t>'s set of page number <tag>, missing into the
+  * STLB and then the page table. The STLB tags huge pages apart from base pages.
+  *
+  * @param t is the L1 array for the access
+  * @param tag is the page number
+  * @param huge is 1 if the page is a huge page
+  */
+ void tlb_lookup(tlb_t* t, addr_t tag, int huge) {
+     if (probe(t, tag)) {
+         return;
+     }
+     translation_cycles += tlb_config.stlb_hit;
+     if (!probe(&stlb, tag | ((addr_t) huge << 63))) {
+         walks[huge]++;
+         translation_cycles += (tlb_counter_t) walk_levels[huge] * tlb_config.walk;
+     }
+ }
+
+ /**
+  * Function to reset the statistics. The translations are kept.
+  */
+ void tlb_reset_stats() {
+     for (int k = 0; k < 2; k++) {
+         for (int h = 0; h < 2; h++) {
+             tlb_l1[k][h].lookups = 0;
+             tlb_l1[k][h].misses = 0;
+         }
+     }
+     stlb.lookups = 0;
+     stlb.misses = 0;
+     walks[0] = 0;
+     walks[1] = 0;
+     translation_cycles = 0;
+ }
+
+ /**
+  * Function to print a page size in bytes with the largest whole unit.
+  */
+ static void print_size(long long bytes) {
+     const char* units[] = { "B", "KB", "MB", "GB", "TB" };
+     int u = 0;
+     while (u < 4 && bytes >= 1024 && bytes % 1024 == 0) {
+         bytes /= 1024;
+         u++;
+     }
+     printf("%lld%s", bytes, units[u]);
+ }
+
+ /**
+  * Function to print the lookups and misses of one TLB array.
+  */
+ static void print_array(tlb_t* t) {
+     printf("tlb: %-9s %5d entries %2d-way, %llu lookups, %llu misses (%.4f%%)\n", t->name,
+            t->sets * t->ways, t->ways, t->lookups, t->misses, t->lookups ? 100.0 * t->misses / t->lookups : 0.0);
+ }
+
+ /**
+  * Function to print the page sizes and walk depths, the lookups and misses of every
+  * TLB array, the page walks and the translation cycles they cost beyond the cache
+  * lookup.
+  *
+  * @param accesses is the number of accesses
+  */
+ void tlb_print_stats(unsigned long long accesses) {
+     printf("tlb: %s, ", policy_name(tlb_policy));
+     print_size(tlb_config.page);
+     printf(" and ");
+     print_size(tlb_config.huge_page);
+     printf(" pages, %d%% of the address space in huge pages, walks of %d and %d levels at %d cycles"
+            " each, %d cycle STLB\n", tlb_config.huge, walk_levels[0], walk_levels[1], tlb_config.walk,
+            tlb_config.stlb_hit);
+     print_array(&tlb_l1[TLB_ITLB][0]);
+     print_array(&tlb_l1[TLB_ITLB][1]);
+     print_array(&tlb_l1[TLB_DTLB][0]);
+     print_array(&tlb_l1[TLB_DTLB][1]);
+     print_array(&stlb);
+     printf("tlb: %llu page walks (%llu for huge pages), %llu translation cycles beyond the cache"
+            " lookup (%.4f per access)\n", walks[0] + walks[1], walks[1], translation_cycles,
+            accesses ? (double) translation_cycles / accesses : 0.0);
+ }
+
+ /**
+  * Function to free the TLBs.
+  */
+ void tlb_cleanup() {
+     tlb_t* arrays[] = { &tlb_l1[0][0], &tlb_l1[0][1], &tlb_l1[1][0], &tlb_l1[1][1], &stlb };
+     for (int i = 0; i < 5; i++) {
+         free(arrays[i]->tags);
+         free(arrays[i]->state);
+         free(arrays[i]->ranks);
+         arrays[i]->tags = NULL;
+         arrays[i]->state = NULL;
+         arrays[i]->ranks = NULL;
+     }
+ }
@@ -0,0 +1,162 @@
+/**
+ * @author ECE 3058 TAs
+ */
+
+#ifndef __TLB_H
+#define __TLB_H
+
+#include "cachesim.h"
+#include "policy.h"
+
+/**
+ * This file contains the TLB model. With --tlb every access is also translated, in
+ * parallel with the cache lookup, through a two-level TLB hierarchy like a current x86
+ * core's:
+ *  - L1: an instruction TLB for IFETCH and a data TLB for reads and writes, each split
+ *  into an array for base pages and an array for huge pages
+ *  - L2: one unified second-level TLB (STLB) holding both kinds of translations and
+ *  both page sizes
+ *  - a miss in the STLB walks a radix page table of 9 bits per level (x86-64 style),
+ *  so a huge page needs fewer levels than a base page
+ * Traces carry no page table, so which pages are huge is modeled: every huge-page-sized
+ * region of the address space is backed by a huge page with probability <huge>%,
+ * decided by a hash of the region number, so the choice is the same in every run.
+ *
+ * Every array is a set-associative tag array with the cache's block state and the same
+ * replacement code: the LRU stack of lrustack.h or SRRIP from policy.h.
+ *
+ * An L1 hit is free, since it overlaps the cache lookup (a VIPT cache). An STLB hit
+ * costs <stlb_hit> cycles and a walk <walk> cycles per level on top of that. Walks
+ * are assumed to miss the page-walk caches, so the cost is an upper estimate.
+ *
+ * NOTES:
+ *      - Trace addresses are treated as virtual, before --page-map translates them.
+ *      - There is no address space identifier: streams sharing the cache (--mix) share
+ *      translations the same way they share blocks.
+ *      - TLB contents are not part of a checkpoint.
+ */
+
+#define TLB_ITLB 0
+#define TLB_DTLB 1
+
+#define TLB_LEVEL_BITS 9    // Page table index bits per level
+
+typedef unsigned long long tlb_counter_t;
+
+/**
+ * Size of one TLB array, given as entries:ways.
+ */
+typedef struct tlb_geometry_t {
+    int entries;
+    int ways;
+} tlb_geometry_t;
+
+/**
+ * TLB sizes and timing, set with --tlb=lru|srrip,key=value,...
+ */
+typedef struct tlb_config_t {
+    tlb_geometry_t itlb;        // L1 instruction TLB, base pages
+    tlb_geometry_t itlb_huge;   // ...huge pages
+    tlb_geometry_t dtlb;        // L1 data TLB, base pages
+    tlb_geometry_t dtlb_huge;   // ...huge pages
+    tlb_geometry_t stlb;        // Unified L2 TLB, both page sizes
+    int stlb_hit;               // Cycles of an STLB lookup
+    int walk;                   // Cycles per page table level of a walk
+    long long page;             // Base page size in bytes, power of 2
+    long long huge_page;        // Huge page size in bytes, power of 2
+    int huge;                   // Percent of huge-page-sized regions backed by a huge page
+} tlb_config_t;
+
+/**
+ * One set-associative TLB array. The state of entry <i> is state[i], its page number
+ * tags[i] and its LRU rank ranks[i].
+ */
+typedef struct tlb_t {
+    const char* name;
+    int sets;
+    int ways;
+    addr_t* tags;               // Page number, with the huge bit at the top in the STLB
+    cache_block_t* state;       // Valid bit and RRPV
+    int* ranks;                 // LRU ranks, lrustack.h
+    addr_t last_tag;            // Tag of the entry used last, which is MRU
+    int last;                   // ...and its index
+    tlb_counter_t lookups;
+    tlb_counter_t misses;
+} tlb_t;
+
+extern int tlb_enabled;             // 1 to model the TLBs
+extern int tlb_policy;              // Replacement policy, POLICY_LRU or POLICY_SRRIP
+extern tlb_config_t tlb_config;
+extern int tlb_page_bits;           // log2 of the base page size
+extern int tlb_huge_bits;           // ...and of the huge page size
+extern tlb_t tlb_l1[2][2];          // [TLB_ITLB or TLB_DTLB][huge]
+
+/**
+ * Function to find a translation in <t>'s set of page number <tag>, missing into the
+ * STLB and the page table. Only called when <tag> is not the entry <t> used last.
+ */
+void tlb_lookup(tlb_t* t, addr_t tag, int huge);
+
+/**
+ * Function to check whether virtual address <vaddr> is in a huge page.
+ */
+static inline int tlb_is_huge(addr_t vaddr) {
+    if (tlb_config.huge == 0) {
+        return 0;
+    }
+    unsigned long long h = (vaddr >> tlb_huge_bits) * 0x9E3779B97F4A7C15ULL;
+    return (int) ((h >> 32) % 100) < tlb_config.huge;
+}
+
+/**
+ * Function to translate virtual address <vaddr> for an access of type <access_type>.
+ * Repeated accesses to the page an L1 array used last skip the set lookup.
+ */
+static inline void tlb_access(addr_t vaddr, int access_type) {
+    int huge = tlb_is_huge(vaddr);
+    tlb_t* t = &tlb_l1[access_type == IFETCH ? TLB_ITLB : TLB_DTLB][huge];
+    addr_t tag = vaddr >> (huge ? tlb_huge_bits : tlb_page_bits);
+    if (tag == t->last_tag) {
+        t->lookups++;
+        t->state[t->last].rrpv = 0;
+        return;
+    }
+    tlb_lookup(t, tag, huge);
+}
+
+/**
+ * Function to apply a --tlb specification: the replacement policy, "lru" or "srrip",
+ * followed by comma separated key=value settings (itlb, itlb_huge, dtlb, dtlb_huge and
+ * stlb as entries:ways, stlb_hit, walk, page, huge_page, huge).
+ *
+ * @return 0 on success, -1 on error
+ */
+int tlb_parse(const char* spec);
+
+/**
+ * Function to check the configuration and allocate the TLBs.
+ *
+ * @param addr_bits is the number of address bits simulated
+ * @return 0 on success, -1 on error
+ */
+int tlb_init(int addr_bits);
+
+/**
+ * Function to reset the statistics. The translations are kept.
+ */
+void tlb_reset_stats(void);
+
+/**
+ * Function to print the lookups and misses of every TLB array, the page walks and the
+ * translation cycles they cost beyond the cache lookup.
+ *
+ * @param accesses is the number of accesses
+ */
+void tlb_print_stats(unsigned long long accesses);
+
+/**
+ * Function to free the TLBs.
+ */
+void tlb_cleanup(void);
+
+#endif
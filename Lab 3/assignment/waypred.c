@@ -0,0 +1,83 @@
+/**
+ * @author ECE 3058 TAs
+ */
+
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include "waypred.h"
+
+ int waypred_kind = WAYPRED_NONE;
+ int* waypred_pc_table = NULL;
+ waypred_counter_t waypred_first = 0;
+ waypred_counter_t waypred_second = 0;
+ waypred_counter_t waypred_missed = 0;
+
+ static const char* waypred_names[] = { "none", "mru", "pc" };
+
+ /**
+  * Function to convert a predictor name into a WAYPRED_* value.
+  *
+  * @param name is the name given on the command line
+  * @return the WAYPRED_* value, or -1 if the name is unknown
+  */
+ int waypred_parse(const char* name) {
+     for (int i = 0; i < (int) (sizeof(waypred_names) / sizeof(waypred_names[0])); i++) {
+         if (strcmp(name, waypred_names[i]) == 0) {
+             return i;
+         }
+     }
+     return -1;
+ }
+
+ /**
+  * Function to get the name of predictor <kind>.
+  */
+ const char* waypred_name(int kind) {
+     return waypred_names[kind];
+ }
+
+ /**
+  * Function to select the predictor to model. The PC table is a section of the cache
+  * state arena, so it is checkpointed with the cache and starts out all zeros, every
+  * entry predicting way 0.
+  *
+  * @param kind is the WAYPRED_* predictor to model
+  */
+ void waypred_init(int kind) {
+     waypred_kind = kind;
+ }
+
+ /**
+  * Function to print the predictor statistics: probe outcomes, average probe count
+  * and average hit latency.
+  */
+ void waypred_print_stats() {
+     waypred_counter_t hits = waypred_first + waypred_second;
+     waypred_counter_t total = hits + waypred_missed;
+     // A miss reads the predicted way and then the rest, the same as a second-probe hit
+     double probes = total ? (double) (waypred_first + 2 * (waypred_second + waypred_missed)) / total : 0.0;
+     double latency = hits ? (double) (waypred_first * WAYPRED_FIRST_PROBE_CYCLES
+                                       + waypred_second * WAYPRED_SECOND_PROBE_CYCLES) / hits : 0.0;
+
+     printf("waypred: %s, first-probe hits %llu, second-probe hits %llu, mispredictions %llu,"
+            " avg probes %.4f, avg hit latency %.4f cycles\n",
+            waypred_names[waypred_kind], waypred_first, waypred_second,
+            waypred_second + waypred_missed, probes, latency);
+ }
+
+ /**
+  * Function to reset the predictor statistics. The predictor state is kept.
+  */
+ void waypred_reset_stats() {
+     waypred_first = 0;
+     waypred_second = 0;
+     waypred_missed = 0;
+ }
+
+ /**
+  * Function to let go of the predictor state, which the cache state arena owns.
+  */
+ void waypred_cleanup() {
+     waypred_pc_table = NULL;
+ }
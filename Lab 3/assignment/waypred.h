@@ -0,0 +1,105 @@
+/**
+ * @author ECE 3058 TAs
+ */
+
+#ifndef __WAYPRED_H
+#define __WAYPRED_H
+
+/**
+ * This file contains the way prediction model. A way-predicted cache reads only the
+ * predicted way on the first probe and the remaining ways on a second probe, so a
+ * correct prediction saves the energy of reading every way and a wrong one costs an
+ * extra cycle. Two predictors are modeled:
+ *  - mru: predict the most recently used way of the set
+ *  - pc:  predict the way last used by the same instruction address
+ * Any access whose first probe does not hit, including a miss, is a misprediction.
+ *
+ * NOTES:
+ *      - The simulator always probes the predicted way first in its own lookup (the
+ *      MRU way when no predictor is selected), so most hits cost O(1) to simulate.
+ *      - Only set-associative index functions are supported. A skewed cache has no
+ *      single set to take an MRU way from.
+ */
+
+#define WAYPRED_NONE 0
+#define WAYPRED_MRU 1
+#define WAYPRED_PC 2
+
+#define WAYPRED_PC_ENTRIES 4096         // Entries in the PC-indexed table, power of 2
+#define WAYPRED_FIRST_PROBE_CYCLES 1    // Hit latency when the predicted way hits
+#define WAYPRED_SECOND_PROBE_CYCLES 2   // Hit latency when the second probe hits
+
+typedef unsigned long long waypred_counter_t;
+
+extern int waypred_kind;                    // Selected predictor, WAYPRED_*
+extern int* waypred_pc_table;               // Way last used by each PC hash, in the cache state arena
+extern waypred_counter_t waypred_first;     // Hits on the first probe
+extern waypred_counter_t waypred_second;    // Hits on the second probe
+extern waypred_counter_t waypred_missed;    // Misses, which pay for both probes
+
+/**
+ * Function to get the table slot of <pc> in the PC-indexed predictor.
+ */
+static inline int waypred_pc_slot(unsigned long long pc) {
+    return (int) (((pc >> 2) ^ (pc >> 14)) & (WAYPRED_PC_ENTRIES - 1));
+}
+
+/**
+ * Function to record the outcome of an access and train the predictor.
+ *
+ * @param pc is the instruction address of the access
+ * @param predicted is the way that was probed first
+ * @param hit_way is the way that hit, or -1 on a miss
+ * @param final_way is the way that holds the block after the access
+ */
+static inline void waypred_update(unsigned long long pc, int predicted, int hit_way, int final_way) {
+    if (hit_way == predicted) {
+        waypred_first++;
+    } else if (hit_way >= 0) {
+        waypred_second++;
+    } else {
+        waypred_missed++;
+    }
+    if (waypred_kind == WAYPRED_PC) {
+        waypred_pc_table[waypred_pc_slot(pc)] = final_way;
+    }
+}
+
+/**
+ * Function to convert a predictor name ("none", "mru", "pc") into a WAYPRED_* value.
+ *
+ * @param name is the name given on the command line
+ * @return the WAYPRED_* value, or -1 if the name is unknown
+ */
+int waypred_parse(const char* name);
+
+/**
+ * Function to get the name of predictor <kind>.
+ */
+const char* waypred_name(int kind);
+
+/**
+ * Function to select the predictor to model. Its PC table lives in the cache state
+ * arena (see cachesim.h).
+ *
+ * @param kind is the WAYPRED_* predictor to model
+ */
+void waypred_init(int kind);
+
+/**
+ * Function to print the predictor statistics: probe outcomes, average probe count
+ * and average hit latency.
+ */
+void waypred_print_stats(void);
+
+/**
+ * Function to reset the predictor statistics. The predictor state is kept.
+ */
+void waypred_reset_stats(void);
+
+/**
+ * Function to let go of the predictor state, which the cache state arena owns.
+ */
+void waypred_cleanup(void);
+
+#endif
@@ -6,6 +6,8 @@
 #include "swap.h"
 #include "stats.h"
 #include "swapops.h"
+#include "zswap.h"
+#include "swapfile.h"
 
 /* Simulator data structures */
 uint8_t *mem;
@@ -40,7 +42,7 @@ int main(int argc, char **argv)
     /* Read command line options */
     FILE *fin = 0;
     int opt;
-    while (-1 != (opt = getopt(argc, argv, "i:hscr:"))) {
+    while (-1 != (opt = getopt(argc, argv, "i:hscr:zf:"))) {
         switch (opt) {
         case 'i':
             fin = fopen(optarg, "r");
@@ -57,11 +59,19 @@ int main(int argc, char **argv)
             check_corruption = 1;
             printf("-> Note: Strict memory corruption checking is enabled.\n");
             break;
+        case 'z':
+            swap_compress = 1;
+            break;
+        case 'f':
+            swap_file_path = optarg;
+            break;
         case 'r':
             if (strcmp(optarg, "random") == 0) {
                 replacement = RANDOM;
             } else if (strcmp(optarg, "clocksweep") == 0) {
                 replacement = CLOCKSWEEP;
+            } else if (strcmp(optarg, "enhanced") == 0) {
+                replacement = ENHANCED_CLOCK;
             } else {
                 fprintf(stderr, "Unknown replacement algorithm: %s", optarg);
                 exit(1);
@@ -78,6 +88,10 @@ int main(int argc, char **argv)
         fprintf(stderr, "ERROR: You must specify a trace filename or stdin.\n");
         print_help_and_exit();
     }
+    if (swap_compress && swap_file_path) {
+        fprintf(stderr, "ERROR: -z and -f cannot be used together.\n");
+        print_help_and_exit();
+    }
     if (!replacement) {
 	 replacement = RANDOM;
         // fprintf(stderr, "ERROR: You must select a replacement algorithm using -r.\n");
@@ -93,6 +107,7 @@ int main(int argc, char **argv)
     uint32_t step = 0;
 
     system_init();
+    if (swap_file_path) swapfile_open();
     if (check_corruption) check_validity(0);
 
     while ((fgets(buf, sizeof(buf), fin))) {
@@ -150,6 +165,7 @@ int main(int argc, char **argv)
         step++;                 /* Count step number for easy debugging */
     }
     fclose(fin);
+    swapfile_close();
 
     /* Cleanup and print statistics */
     free(mem);
@@ -167,6 +183,8 @@ int main(int argc, char **argv)
     if (swap_queue.size > 0)  {
         printf("Swap Not Freed     : %" PRIu64 " KB\n", (((uint64_t) swap_queue.size) * PAGE_SIZE) >> 10);
     }
+    zswap_print_stats();
+    swapfile_print_stats();
 }
 
 void check_validity(int checks) {
@@ -286,7 +304,9 @@ void print_help_and_exit() {
     printf("./vm-sim [OPTIONS] -i traces/file.trace -r<replacement algorithm>\n");
     printf("  -i\t\tReads the trace from the specified path\n");
     printf("  -s\t\tReads the trace from standard input\n");
-    printf("  -r\t\tSelect the replacement algorithm (either 'random' or 'clocksweep')\n");
+    printf("  -r\t\tSelect the replacement algorithm ('random', 'clocksweep' or 'enhanced')\n");
+    printf("  -z\t\tCompresses swapped pages and keeps zero pages as a flag only\n");
+    printf("  -f\t\tSwaps to the specified file through a background I/O thread\n");
     printf("  -c\t\tEnables strict memory corruption checking\n");
     printf("    \t\t(automatically checks a variety of conditions that can cause bugs)\n");
     printf("  -h\t\tThis helpful output\n");
@@ -62,6 +62,7 @@ extern pcb_t *current_process;  /* The currently running process */
 extern uint8_t replacement;
 #define RANDOM 1
 #define CLOCKSWEEP 2
+#define ENHANCED_CLOCK 3
 
 /*
  * Stats.
@@ -4,27 +4,43 @@
 #include "swap.h"
 #include "util.h"
 
-static uint64_t TOKEN = 1;
-
-swap_info_t *create_entry(void)
+/*
+ * Grow the queue by one slab of SWAP_SLAB_SLOTS slots and put them all on the
+ * free list, lowest slot first.
+ */
+static void swap_queue_grow(swap_queue_t *queue)
 {
-    swap_info_t *new_info = calloc(1, sizeof(swap_info_t));
-    if (!new_info) {
+    uint32_t capacity = queue->capacity + SWAP_SLAB_SLOTS;
+    swap_info_t **slots = realloc(queue->slots, capacity * sizeof(swap_info_t *));
+    swap_info_t *slab = calloc(SWAP_SLAB_SLOTS, sizeof(swap_info_t));
+    if (!slots || !slab) {
         panic("could not allocate swap entry");
     }
-    new_info->token = TOKEN++;
+    queue->slots = slots;
+    for (uint32_t i = SWAP_SLAB_SLOTS; i-- > 0;) {
+        slab[i].slot = queue->capacity + i;
+        slab[i].next = queue->free;
+        queue->slots[queue->capacity + i] = &slab[i];
+        queue->free = &slab[i];
+    }
+    queue->capacity = capacity;
+}
+
+swap_info_t *create_entry(swap_queue_t *queue)
+{
+    if (!queue->free) {
+        swap_queue_grow(queue);
+    }
+    swap_info_t *new_info = queue->free;
+    queue->free = new_info->next;
+    new_info->next = NULL;
+    new_info->token = ((uint64_t) new_info->generation << 32) | ((uint64_t) new_info->slot + 1);
     return new_info;
 }
 
 void swap_queue_enqueue(swap_queue_t *queue, swap_info_t* info)
 {
-    info->next = NULL;
-    if (queue->head == NULL) {
-        queue->head = queue->tail = info;
-    } else {
-        queue->tail->next = info;
-        queue->tail = info;
-    }
+    (void) info;
     queue->size++;
     if (queue->size > queue->size_max) {
         queue->size_max = queue->size;
@@ -34,38 +50,24 @@ void swap_queue_enqueue(swap_queue_t *queue, swap_info_t* info)
 
 void swap_queue_dequeue(swap_queue_t *queue, uint64_t token)
 {
-    swap_info_t *curr = queue->head;
-    swap_info_t *prev = NULL;
-
-    while (curr) {
-        if (curr->token == token) {
-            if (prev) {
-                prev->next = curr->next;
-            } else {
-                queue->head = curr->next;
-            }
-            if (curr == queue->tail) {
-                queue->tail = prev;
-            }
-            break;
-        }
-        prev = curr;
-        curr = curr->next;
+    swap_info_t *curr = swap_queue_find(queue, token);
+    if (!curr) {
+        return;
     }
     queue->size--;
-    curr->next = NULL;
-    free(curr);
+    zswap_release(&curr->page);
+    curr->token = 0;
+    curr->generation++;
+    curr->next = queue->free;
+    queue->free = curr;
 }
 
 swap_info_t *swap_queue_find(swap_queue_t *queue, uint64_t token)
 {
-    swap_info_t *curr = queue->head;
-
-    while (curr) {
-        if (curr->token == token) {
-            return curr;
-        }
-        curr = curr->next;
+    uint32_t slot = (uint32_t) token - 1;
+    if (token == 0 || slot >= queue->capacity) {
+        return NULL;
     }
-    return NULL;
+    swap_info_t *curr = queue->slots[slot];
+    return (curr->token == token) ? curr : NULL;
 }
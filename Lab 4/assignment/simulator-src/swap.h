@@ -2,25 +2,40 @@
 
 #include "pagesim.h"
 #include "types.h"
+#include "zswap.h"
 
 typedef uint64_t swap_entry_t;
 
+/* Swap slots are allocated this many at a time */
+#define SWAP_SLAB_SLOTS 64
+
+/*
+ * A swap slot. Slots live in slabs that are never freed or moved, and a slot
+ * that is not in use sits on the swap queue's free list.
+ *
+ * A token is the slot number plus one in the low 32 bits and the slot's
+ * generation in the high 32 bits. The generation changes every time the slot
+ * is freed, so a stale token never finds a reused slot.
+ */
 typedef struct swap_info {
 
-    uint64_t token;
-    uint8_t  page_data[PAGE_SIZE];
+    uint64_t token;             /* 0 while the slot is free */
+    uint32_t slot;              /* Index in the slot table */
+    uint32_t generation;        /* Times the slot has been freed */
+    zswap_handle_t page;        /* Where the page's data is kept */
 
-    struct swap_info *next;
+    struct swap_info *next;     /* Next free slot */
 } swap_info_t;
 
 typedef struct _swap_queue_t {
-    swap_info_t *head;
-    swap_info_t *tail;
+    swap_info_t **slots;        /* Slot table, indexed by slot number */
+    uint32_t capacity;          /* Slots allocated so far */
+    swap_info_t *free;          /* Free list */
     uint64_t size;
     uint64_t size_max;
 } swap_queue_t;
 
-swap_info_t *create_entry(void);
+swap_info_t *create_entry(swap_queue_t *queue);
 void swap_queue_enqueue(swap_queue_t *queue, swap_info_t* info);
 void swap_queue_dequeue(swap_queue_t *queue, uint64_t token);
 swap_info_t *swap_queue_find(swap_queue_t *queue, uint64_t token);
@@ -0,0 +1,280 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "swapfile.h"
+#include "util.h"
+
+#define NO_SLOT UINT32_MAX
+
+#define CACHE_EMPTY 0
+#define CACHE_PENDING 1     /* Read-ahead queued or in flight */
+#define CACHE_READY 2
+
+const char *swap_file_path = NULL;
+
+/*
+ * A queued request: a write of the buffer at the same position in
+ * write_bufs, or a read-ahead into a cache entry.
+ */
+typedef struct io_request {
+    uint8_t readahead;
+    uint32_t slot;
+    uint64_t seq;           /* Write number, for durability */
+    uint32_t entry;         /* Cache entry, for a read-ahead */
+    uint64_t ticket;        /* ...and the entry's ticket when it was queued */
+} io_request_t;
+
+typedef struct cache_entry {
+    uint32_t slot;          /* NO_SLOT once dropped */
+    uint8_t state;
+    uint64_t ticket;        /* Changes whenever the entry is dropped */
+    uint8_t data[PAGE_SIZE];
+} cache_entry_t;
+
+static int fd = -1;
+static pthread_t io_thread;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t not_empty = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t done = PTHREAD_COND_INITIALIZER;    /* A request finished */
+static int stopping = 0;
+
+static io_request_t queue[SWAPFILE_QUEUE_DEPTH];
+static uint8_t write_bufs[SWAPFILE_QUEUE_DEPTH][PAGE_SIZE];
+static uint32_t queue_head = 0;     /* Request the I/O thread is on */
+static uint32_t queue_count = 0;    /* Requests queued, including that one */
+
+static cache_entry_t cache[SWAPFILE_CACHE_SLOTS];
+
+static uint64_t *slot_seq = NULL;   /* Last write queued to each slot, 0 if none */
+static uint32_t file_slots = 0;     /* Slots preallocated in the file */
+static uint32_t last_read = NO_SLOT;
+static uint64_t issued_seq = 0;     /* Writes queued */
+static uint64_t durable_seq = 0;    /* ...and finished */
+
+static uint64_t writes = 0;
+static uint64_t writes_blocked = 0; /* Writes that found every buffer busy */
+static uint64_t reads = 0;
+static uint64_t reads_waited = 0;   /* Reads that waited for their page's write */
+static uint64_t readaheads = 0;
+static uint64_t readahead_hits = 0;
+
+/*
+ * Runs the queued requests in order until swapfile_close stops it.
+ */
+static void *io_main(void *arg) {
+    (void) arg;
+    pthread_mutex_lock(&lock);
+    for (;;) {
+        while (queue_count == 0 && !stopping) {
+            pthread_cond_wait(&not_empty, &lock);
+        }
+        if (queue_count == 0) {
+            break;
+        }
+        io_request_t req = queue[queue_head];
+        pthread_mutex_unlock(&lock);
+
+        off_t off = (off_t) req.slot * PAGE_SIZE;
+        ssize_t n = req.readahead ? pread(fd, cache[req.entry].data, PAGE_SIZE, off)
+                                  : pwrite(fd, write_bufs[queue_head], PAGE_SIZE, off);
+        if (n != PAGE_SIZE) {
+            panic("swap file I/O failed");
+        }
+
+        pthread_mutex_lock(&lock);
+        if (!req.readahead) {
+            durable_seq = req.seq;
+        } else if (cache[req.entry].ticket == req.ticket) {
+            cache[req.entry].state = CACHE_READY;
+        } else {
+            cache[req.entry].state = CACHE_EMPTY;   /* Dropped while it was being read */
+        }
+        queue_head = (queue_head + 1) % SWAPFILE_QUEUE_DEPTH;
+        queue_count--;
+        pthread_cond_broadcast(&done);
+    }
+    pthread_mutex_unlock(&lock);
+    return NULL;
+}
+
+/*
+ * Puts a request at the tail of the queue and returns its position. The lock
+ * must be held and the queue not full.
+ */
+static uint32_t enqueue(io_request_t req) {
+    uint32_t pos = (queue_head + queue_count) % SWAPFILE_QUEUE_DEPTH;
+    queue[pos] = req;
+    queue_count++;
+    pthread_cond_signal(&not_empty);
+    return pos;
+}
+
+/*
+ * Drops the cached copy of a slot, if there is one. The lock must be held.
+ */
+static void cache_drop(uint32_t slot) {
+    cache_entry_t *e = &cache[slot % SWAPFILE_CACHE_SLOTS];
+    if (e->slot == slot) {
+        e->slot = NO_SLOT;
+        e->ticket++;
+        if (e->state == CACHE_READY) {
+            e->state = CACHE_EMPTY;
+        }
+    }
+}
+
+/*
+ * Makes room in the file for slot <slot>, doubling its size as needed.
+ */
+static void grow(uint32_t slot) {
+    if (slot < file_slots) {
+        return;
+    }
+    uint32_t slots = file_slots ? file_slots : SWAPFILE_GROW_SLOTS;
+    while (slot >= slots) {
+        slots *= 2;
+    }
+    int err = posix_fallocate(fd, 0, (off_t) slots * PAGE_SIZE);
+    if (err != 0 && err != EOPNOTSUPP && err != EINVAL) {
+        panic("could not grow the swap file");
+    }
+    if (err != 0 && ftruncate(fd, (off_t) slots * PAGE_SIZE) != 0) {
+        panic("could not grow the swap file");
+    }
+    pthread_mutex_lock(&lock);
+    uint64_t *seq = realloc(slot_seq, slots * sizeof(uint64_t));
+    if (!seq) {
+        panic("could not allocate swap entry");
+    }
+    memset(seq + file_slots, 0, (slots - file_slots) * sizeof(uint64_t));
+    slot_seq = seq;
+    file_slots = slots;
+    pthread_mutex_unlock(&lock);
+}
+
+void swapfile_open(void) {
+    fd = open(swap_file_path, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0) {
+        perror("Unable to create swap file");
+        exit(1);
+    }
+    for (uint32_t i = 0; i < SWAPFILE_CACHE_SLOTS; i++) {
+        cache[i].slot = NO_SLOT;
+    }
+    grow(0);
+    if (pthread_create(&io_thread, NULL, io_main, NULL) != 0) {
+        panic("could not start the swap I/O thread");
+    }
+}
+
+/*
+ * Queues read-aheads of the slots after <slot> that hold pages, skipping any
+ * already cached and giving up rather than waiting for the queue. The lock
+ * must be held.
+ */
+static void read_ahead(uint32_t slot) {
+    for (uint32_t s = slot + 1; s <= slot + SWAPFILE_READAHEAD && s < file_slots; s++) {
+        cache_entry_t *e = &cache[s % SWAPFILE_CACHE_SLOTS];
+        if (queue_count == SWAPFILE_QUEUE_DEPTH) {
+            return;
+        }
+        if (!slot_seq[s] || e->slot == s || e->state == CACHE_PENDING) {
+            continue;
+        }
+        e->slot = s;
+        e->state = CACHE_PENDING;
+        e->ticket++;
+        io_request_t req = { 1, s, 0, s % SWAPFILE_CACHE_SLOTS, e->ticket };
+        enqueue(req);
+        readaheads++;
+    }
+}
+
+void swapfile_read(uint32_t slot, void *dst) {
+    pthread_mutex_lock(&lock);
+    reads++;
+    if (slot_seq[slot] > durable_seq) {
+        reads_waited++;
+        while (slot_seq[slot] > durable_seq) {
+            pthread_cond_wait(&done, &lock);
+        }
+    }
+    cache_entry_t *e = &cache[slot % SWAPFILE_CACHE_SLOTS];
+    while (e->slot == slot && e->state == CACHE_PENDING) {
+        pthread_cond_wait(&done, &lock);
+    }
+    int hit = (e->slot == slot && e->state == CACHE_READY);
+    if (hit) {
+        memcpy(dst, e->data, PAGE_SIZE);
+        readahead_hits++;
+        cache_drop(slot);
+    }
+    /* Only read ahead while reads look sequential, as Linux does, so random
+       faults do not fill the queue with reads nobody wants */
+    if (hit || slot == last_read + 1) {
+        read_ahead(slot);
+    }
+    last_read = slot;
+    pthread_mutex_unlock(&lock);
+
+    if (!hit && pread(fd, dst, PAGE_SIZE, (off_t) slot * PAGE_SIZE) != PAGE_SIZE) {
+        panic("swap file I/O failed");
+    }
+}
+
+void swapfile_write(uint32_t slot, const void *src) {
+    grow(slot);
+    pthread_mutex_lock(&lock);
+    writes++;
+    if (queue_count == SWAPFILE_QUEUE_DEPTH) {
+        writes_blocked++;
+        while (queue_count == SWAPFILE_QUEUE_DEPTH) {
+            pthread_cond_wait(&done, &lock);
+        }
+    }
+    cache_drop(slot);
+    io_request_t req = { 0, slot, ++issued_seq, 0, 0 };
+    slot_seq[slot] = req.seq;
+    uint32_t pos = enqueue(req);
+    /* The I/O thread only touches this buffer once it reaches the request,
+       which needs the lock this thread still holds */
+    memcpy(write_bufs[pos], src, PAGE_SIZE);
+    pthread_mutex_unlock(&lock);
+}
+
+void swapfile_discard(uint32_t slot) {
+    pthread_mutex_lock(&lock);
+    slot_seq[slot] = 0;
+    cache_drop(slot);
+    pthread_mutex_unlock(&lock);
+}
+
+void swapfile_close(void) {
+    if (fd < 0) {
+        return;
+    }
+    pthread_mutex_lock(&lock);
+    stopping = 1;
+    pthread_cond_signal(&not_empty);
+    pthread_mutex_unlock(&lock);
+    pthread_join(io_thread, NULL);
+    close(fd);
+    fd = -1;
+    free(slot_seq);
+    slot_seq = NULL;
+}
+
+void swapfile_print_stats(void) {
+    if (!swap_file_path) {
+        return;
+    }
+    printf("Swap File          : %s, %" PRIu64 " KB preallocated\n", swap_file_path,
+           ((uint64_t) file_slots * PAGE_SIZE) >> 10);
+    printf("Swap File Writes   : %" PRIu64 " (%" PRIu64 " waited for a free buffer)\n", writes, writes_blocked);
+    printf("Swap File Reads    : %" PRIu64 " (%" PRIu64 " waited for their write, %" PRIu64 " read ahead"
+           " of %" PRIu64 " read-aheads)\n", reads, reads_waited, readahead_hits, readaheads);
+}
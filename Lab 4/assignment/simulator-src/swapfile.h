@@ -0,0 +1,60 @@
+#pragma once
+
+#include "pagesim.h"
+#include "types.h"
+
+/*
+ * The file-backed swap device.
+ *
+ * With -f <path> swapped pages are kept in a file instead of host memory. Swap
+ * slot n is the page at offset n * PAGE_SIZE, and the file is preallocated
+ * SWAPFILE_GROW_SLOTS slots at a time, doubling as swap grows.
+ *
+ * Writes go through a background I/O thread. swap_write copies the page into
+ * one of SWAPFILE_QUEUE_DEPTH buffers and returns, blocking only when every
+ * buffer is still waiting for the disk. Requests are served in order, so a
+ * page is durable once every write queued before it has finished.
+ *
+ * swap_read blocks only while the page's latest write is still queued, then
+ * reads it with pread. Each read also queues a read-ahead of the next
+ * SWAPFILE_READAHEAD slots into a small direct-mapped cache, so a page swapped
+ * out next to the one just read back in is usually already in memory when it
+ * is needed. A write or free of a slot drops its cached copy.
+ */
+
+#define SWAPFILE_QUEUE_DEPTH 32     /* Writes and read-aheads in flight */
+#define SWAPFILE_READAHEAD 4        /* Slots read ahead after every read */
+#define SWAPFILE_CACHE_SLOTS 64     /* Pages the read-ahead cache holds */
+#define SWAPFILE_GROW_SLOTS 1024    /* Slots the file starts with */
+
+extern const char *swap_file_path;  /* Swap file (-f), NULL to swap to host memory */
+
+/**
+ * Creates the swap file and starts the I/O thread.
+ */
+void swapfile_open(void);
+
+/**
+ * Reads swap slot <slot> into dst, waiting for its last write if needed.
+ */
+void swapfile_read(uint32_t slot, void *dst);
+
+/**
+ * Queues a write of the page at src to swap slot <slot>.
+ */
+void swapfile_write(uint32_t slot, const void *src);
+
+/**
+ * Forgets swap slot <slot>, which has been freed.
+ */
+void swapfile_discard(uint32_t slot);
+
+/**
+ * Waits for every queued request, stops the I/O thread and closes the file.
+ */
+void swapfile_close(void);
+
+/**
+ * Prints the swap file statistics, when -f is on.
+ */
+void swapfile_print_stats(void);
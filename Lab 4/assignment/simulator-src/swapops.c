@@ -1,4 +1,5 @@
 #include "swapops.h"
+#include "swapfile.h"
 #include "util.h"
 
 swap_queue_t swap_queue;
@@ -9,25 +10,37 @@ void swap_read(pte_t *pte, void *dst) {
     if (!info) {
         panic("Attempted to read an invalid swap entry.\nHINT: How do you check if a swap entry exists, and if it does not, what should you put in memory instead?");
     }
-    memcpy(dst, info->page_data, PAGE_SIZE);
+    if (swap_file_path) {
+        swapfile_read(info->slot, dst);
+    } else {
+        zswap_load(&info->page, dst);
+    }
 }
 
 void swap_write(pte_t *pte, void *src) {
 
     swap_info_t *info = swap_queue_find(&swap_queue, pte->swap);
     if (!info) {
-        info = create_entry(); // creates a swap entry and assigns a token
+        info = create_entry(&swap_queue); // takes a free swap slot and assigns a token
         swap_queue_enqueue(&swap_queue, info);
         pte->swap = info->token;
     }
-    memcpy(info->page_data, src, PAGE_SIZE);
+    if (swap_file_path) {
+        swapfile_write(info->slot, src);    // returns once the page is queued for the I/O thread
+    } else {
+        zswap_store(&info->page, src);
+    }
 }
 
 void swap_free(pte_t *pte) {
     swap_entry_t swp_entry = pte->swap;
-    if (!swap_queue_find(&swap_queue, swp_entry)) {
+    swap_info_t *info = swap_queue_find(&swap_queue, swp_entry);
+    if (!info) {
         panic("Attempted to free an invalid swap entry!");
     }
+    if (swap_file_path) {
+        swapfile_discard(info->slot);
+    }
     swap_queue_dequeue(&swap_queue, pte->swap);
     pte->swap = 0;
 }
@@ -0,0 +1,284 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "zswap.h"
+#include "stats.h"
+#include "util.h"
+
+#define LZ_MIN_MATCH 4
+#define LZ_HASH_BITS 12
+#define LZ_MAX_OFFSET 0xFFFF
+#define LZ_SKIP_SHIFT 5         /* Every 32 misses in a row lengthen the step by one */
+
+uint8_t swap_compress = 0;
+zswap_stats_t zswap_stats;
+
+/* Free chunks of each class, linked through their first bytes */
+static uint8_t *free_chunks[ZSWAP_CLASSES];
+
+/*
+ * Gets the bytes of a chunk of class c.
+ */
+static inline uint32_t class_bytes(uint8_t c) {
+    return ((uint32_t) c + 1) * ZSWAP_CLASS_STEP;
+}
+
+/*
+ * Takes a chunk of class c, carving a new slab when the class has none free.
+ */
+static uint8_t *chunk_alloc(uint8_t c) {
+    if (!free_chunks[c]) {
+        uint8_t *slab = malloc(ZSWAP_SLAB_BYTES);
+        if (!slab) {
+            panic("could not allocate swap entry");
+        }
+        zswap_stats.slab_bytes += ZSWAP_SLAB_BYTES;
+        uint32_t size = class_bytes(c);
+        for (uint32_t off = 0; off + size <= ZSWAP_SLAB_BYTES; off += size) {
+            memcpy(slab + off, &free_chunks[c], sizeof(uint8_t *));
+            free_chunks[c] = slab + off;
+        }
+    }
+    uint8_t *chunk = free_chunks[c];
+    memcpy(&free_chunks[c], chunk, sizeof(uint8_t *));
+    return chunk;
+}
+
+/*
+ * Puts a chunk of class c back on its free list.
+ */
+static void chunk_free(uint8_t *chunk, uint8_t c) {
+    memcpy(chunk, &free_chunks[c], sizeof(uint8_t *));
+    free_chunks[c] = chunk;
+}
+
+/*
+ * Checks whether the page at src is all zeros.
+ */
+static int page_is_zero(const uint8_t *src) {
+    uint64_t word;
+    for (size_t i = 0; i < PAGE_SIZE; i += sizeof(word)) {
+        memcpy(&word, src + i, sizeof(word));
+        if (word) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/*
+ * Writes an LZ length extension: 255 for every full 255, then the rest.
+ */
+static size_t lz_put_length(uint8_t *dst, size_t op, size_t len) {
+    while (len >= 255) {
+        dst[op++] = 255;
+        len -= 255;
+    }
+    dst[op++] = (uint8_t) len;
+    return op;
+}
+
+/*
+ * Writes one sequence: litlen literals, then a match of matchlen bytes at
+ * offset back, or nothing more if matchlen is 0 (the last sequence). The token
+ * holds the literal length in its high nibble and the match length less
+ * LZ_MIN_MATCH in its low one, 15 meaning the length continues after it.
+ *
+ * Returns the new output position, or 0 if the sequence does not fit in cap.
+ */
+static size_t lz_put_sequence(uint8_t *dst, size_t op, size_t cap, const uint8_t *lit, size_t litlen,
+                              size_t offset, size_t matchlen) {
+    size_t need = 1 + litlen / 255 + 1 + litlen + 2 + matchlen / 255 + 1;
+    if (op + need > cap) {
+        return 0;
+    }
+    size_t m = matchlen ? matchlen - LZ_MIN_MATCH : 0;
+    dst[op++] = (uint8_t) (((litlen < 15 ? litlen : 15) << 4) | (m < 15 ? m : 15));
+    if (litlen >= 15) {
+        op = lz_put_length(dst, op, litlen - 15);
+    }
+    memcpy(dst + op, lit, litlen);
+    op += litlen;
+    if (matchlen) {
+        dst[op++] = (uint8_t) offset;
+        dst[op++] = (uint8_t) (offset >> 8);
+        if (m >= 15) {
+            op = lz_put_length(dst, op, m - 15);
+        }
+    }
+    return op;
+}
+
+/*
+ * Compresses n bytes at src into dst, greedily taking the match found through
+ * a hash of the next LZ_MIN_MATCH bytes. Like LZ4, the search steps faster
+ * the longer it goes without a match, so incompressible data is given up on
+ * quickly.
+ *
+ * Returns the compressed length, or 0 if it would not fit in cap bytes.
+ */
+static size_t lz_compress(const uint8_t *src, size_t n, uint8_t *dst, size_t cap) {
+    uint32_t table[1 << LZ_HASH_BITS];  /* Last position + 1 of each hash */
+    memset(table, 0, sizeof(table));
+    size_t ip = 0, anchor = 0, op = 0, misses = 0;
+    while (ip + LZ_MIN_MATCH <= n) {
+        uint32_t seq;
+        memcpy(&seq, src + ip, sizeof(seq));
+        uint32_t h = (seq * 2654435761u) >> (32 - LZ_HASH_BITS);
+        size_t cand = table[h];
+        table[h] = (uint32_t) ip + 1;
+        if (cand && ip - (cand - 1) <= LZ_MAX_OFFSET && !memcmp(src + cand - 1, src + ip, LZ_MIN_MATCH)) {
+            size_t ref = cand - 1;
+            size_t len = LZ_MIN_MATCH;
+            /* Extend eight bytes at a time, then finish byte by byte */
+            uint64_t a, b;
+            while (ip + len + sizeof(a) <= n) {
+                memcpy(&a, src + ref + len, sizeof(a));
+                memcpy(&b, src + ip + len, sizeof(b));
+                if (a != b) {
+                    break;
+                }
+                len += sizeof(a);
+            }
+            while (ip + len < n && src[ref + len] == src[ip + len]) {
+                len++;
+            }
+            op = lz_put_sequence(dst, op, cap, src + anchor, ip - anchor, ip - ref, len);
+            if (!op) {
+                return 0;
+            }
+            ip += len;
+            anchor = ip;
+            misses = 0;
+        } else {
+            /* Step faster through data that keeps failing to match */
+            ip += 1 + (misses++ >> LZ_SKIP_SHIFT);
+        }
+    }
+    return lz_put_sequence(dst, op, cap, src + anchor, n - anchor, 0, 0);
+}
+
+/*
+ * Reads an LZ length extension into len.
+ */
+static size_t lz_get_length(const uint8_t *src, size_t ip, size_t *len) {
+    uint8_t b;
+    do {
+        b = src[ip++];
+        *len += b;
+    } while (b == 255);
+    return ip;
+}
+
+/*
+ * Decompresses len bytes at src into dst. A sequence that ends the input
+ * right after its literals is the last one.
+ */
+static void lz_decompress(const uint8_t *src, size_t len, uint8_t *dst) {
+    size_t ip = 0, op = 0;
+    while (ip < len) {
+        uint8_t token = src[ip++];
+        size_t litlen = token >> 4;
+        if (litlen == 15) {
+            ip = lz_get_length(src, ip, &litlen);
+        }
+        memcpy(dst + op, src + ip, litlen);
+        ip += litlen;
+        op += litlen;
+        if (ip >= len) {
+            break;
+        }
+        size_t offset = (size_t) src[ip] | ((size_t) src[ip + 1] << 8);
+        ip += 2;
+        size_t matchlen = token & 15;
+        if (matchlen == 15) {
+            ip = lz_get_length(src, ip, &matchlen);
+        }
+        matchlen += LZ_MIN_MATCH;
+        if (offset >= matchlen) {
+            memcpy(dst + op, dst + op - offset, matchlen);
+        } else if (offset == 1) {
+            memset(dst + op, dst[op - 1], matchlen);    /* A run of one byte, such as zeros */
+        } else {
+            /* Byte by byte, since the match overlaps what it is copying */
+            for (size_t i = 0; i < matchlen; i++) {
+                dst[op + i] = dst[op + i - offset];
+            }
+        }
+        op += matchlen;
+    }
+}
+
+void zswap_store(zswap_handle_t *h, const void *src) {
+    zswap_release(h);
+    zswap_stats.stores++;
+    if (swap_compress && page_is_zero(src)) {
+        zswap_stats.zero_stores++;
+        zswap_stats.write_time_saved += DISK_PAGE_WRITE_TIME;
+        h->zero = 1;
+        return;
+    }
+
+    uint8_t buf[PAGE_SIZE];
+    size_t len = 0;
+    if (swap_compress) {
+        /* Anything that does not save at least a class step is kept whole */
+        len = lz_compress(src, PAGE_SIZE, buf, PAGE_SIZE - ZSWAP_CLASS_STEP);
+        if (!len) {
+            zswap_stats.raw_stores++;
+        }
+    }
+    h->length = len ? (uint32_t) len : PAGE_SIZE;
+    h->size_class = (uint8_t) ((h->length + ZSWAP_CLASS_STEP - 1) / ZSWAP_CLASS_STEP - 1);
+    h->data = chunk_alloc(h->size_class);
+    memcpy(h->data, len ? buf : src, h->length);
+
+    zswap_stats.compressed_bytes += h->length;
+    zswap_stats.write_time_saved += DISK_PAGE_WRITE_TIME - (uint64_t) DISK_PAGE_WRITE_TIME * h->length / PAGE_SIZE;
+    zswap_stats.stored += class_bytes(h->size_class);
+    if (zswap_stats.stored > zswap_stats.stored_max) {
+        zswap_stats.stored_max = zswap_stats.stored;
+    }
+}
+
+void zswap_load(const zswap_handle_t *h, void *dst) {
+    zswap_stats.loads++;
+    if (h->zero) {
+        zswap_stats.read_time_saved += DISK_PAGE_READ_TIME;
+        memset(dst, 0, PAGE_SIZE);
+        return;
+    }
+    zswap_stats.read_time_saved += DISK_PAGE_READ_TIME - (uint64_t) DISK_PAGE_READ_TIME * h->length / PAGE_SIZE;
+    if (h->length == PAGE_SIZE) {
+        memcpy(dst, h->data, PAGE_SIZE);
+    } else {
+        lz_decompress(h->data, h->length, dst);
+    }
+}
+
+void zswap_release(zswap_handle_t *h) {
+    if (h->data) {
+        chunk_free(h->data, h->size_class);
+        zswap_stats.stored -= class_bytes(h->size_class);
+    }
+    h->data = NULL;
+    h->length = 0;
+    h->zero = 0;
+}
+
+void zswap_print_stats(void) {
+    if (!swap_compress) {
+        return;
+    }
+    zswap_stats_t *s = &zswap_stats;
+    printf("Zero Pages Swapped : %" PRIu64 " of %" PRIu64 " (%" PRIu64 " did not compress)\n",
+           s->zero_stores, s->stores, s->raw_stores);
+    if (s->compressed_bytes) {
+        printf("Compression Ratio  : %.2f\n", (double) (s->stores * PAGE_SIZE) / (double) s->compressed_bytes);
+    } else {
+        printf("Compression Ratio  : n/a, every page swapped was zero\n");
+    }
+    printf("Max Swap Stored    : %" PRIu64 " KB in %" PRIu64 " KB of slabs\n", s->stored_max >> 10, s->slab_bytes >> 10);
+    printf("Disk Time Saved    : %" PRIu64 " ns writing, %" PRIu64 " ns reading\n", s->write_time_saved,
+           s->read_time_saved);
+}
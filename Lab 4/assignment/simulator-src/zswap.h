@@ -0,0 +1,75 @@
+#pragma once
+
+#include "pagesim.h"
+#include "types.h"
+
+/*
+ * Storage for swapped pages.
+ *
+ * Page data lives in size-classed slabs: class i holds chunks of
+ * (i + 1) * ZSWAP_CLASS_STEP bytes, the last class whole pages. A slab is
+ * ZSWAP_SLAB_BYTES carved into chunks of one class, and freed chunks go on
+ * their class's free list for the next page of that size.
+ *
+ * Without compression (the default) every page takes a whole-page chunk. With
+ * -z the backend works like Linux's zswap:
+ *  - a page of all zeros is kept as a flag only, with no chunk at all
+ *  - any other page is compressed with a small LZ77 codec in the style of LZ4
+ *    (literal runs and back references of at least 4 bytes within the page)
+ *    into the smallest class that fits it, or kept whole if it does not shrink
+ *    below a whole page
+ *
+ * Disk time is modeled as proportional to the bytes moved, so a compressed page
+ * costs its share of DISK_PAGE_WRITE_TIME or DISK_PAGE_READ_TIME and a zero page
+ * nothing. The simulator's own AAT still charges full pages.
+ */
+
+#define ZSWAP_CLASS_STEP 256
+#define ZSWAP_CLASSES (PAGE_SIZE / ZSWAP_CLASS_STEP)
+#define ZSWAP_SLAB_BYTES (4 * PAGE_SIZE)
+
+typedef struct zswap_stats {
+    uint64_t stores;            /* Pages written to swap */
+    uint64_t zero_stores;       /* ...that were all zeros */
+    uint64_t raw_stores;        /* ...that did not compress */
+    uint64_t loads;             /* Pages read from swap */
+    uint64_t compressed_bytes;  /* Bytes the stored pages compressed to */
+    uint64_t stored;            /* Bytes of chunks holding pages right now */
+    uint64_t stored_max;        /* ...at most */
+    uint64_t slab_bytes;        /* Bytes of slabs allocated */
+    uint64_t write_time_saved;  /* Modeled disk time saved, in ns */
+    uint64_t read_time_saved;
+} zswap_stats_t;
+
+extern uint8_t swap_compress;   /* 1 to compress swapped pages (-z) */
+extern zswap_stats_t zswap_stats;
+
+/*
+ * Where one swapped page is kept.
+ */
+typedef struct zswap_handle {
+    uint8_t *data;              /* Chunk holding the page, NULL for a zero page */
+    uint32_t length;            /* Bytes of compressed data, PAGE_SIZE if raw */
+    uint8_t zero;               /* 1 if the page is all zeros */
+    uint8_t size_class;         /* Class of the chunk */
+} zswap_handle_t;
+
+/**
+ * Stores the page at src in h, releasing whatever h held before.
+ */
+void zswap_store(zswap_handle_t *h, const void *src);
+
+/**
+ * Copies the page held by h to dst.
+ */
+void zswap_load(const zswap_handle_t *h, void *dst);
+
+/**
+ * Returns h's chunk to its class.
+ */
+void zswap_release(zswap_handle_t *h);
+
+/**
+ * Prints the compression statistics, when -z is on.
+ */
+void zswap_print_stats(void);
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "pagesim.h"
+#include "types.h"
+
+/*
+ * The free-frame bitmap.
+ *
+ * A frame is free when it is neither mapped nor protected. Bit i of level 0 is
+ * set while frame i is free, bit i of level 1 while word i of level 0 has any
+ * bit set, and likewise for level 2 over level 1. Three levels of 64-bit words
+ * cover 64^3 frames, more than a pfn_t can number, so finding the lowest free
+ * frame is one count-trailing-zeros per level however large memory grows.
+ *
+ * The bitmap must be updated wherever a frame changes between free and in use:
+ * free_frames_take when select_victim_frame hands a free frame out, and
+ * free_frames_release when proc_cleanup unmaps a page or unprotects a page table.
+ */
+
+#define FREE_FRAMES_L0 ((NUM_FRAMES + 63) / 64)
+#define FREE_FRAMES_L1 ((FREE_FRAMES_L0 + 63) / 64)
+#define FREE_FRAMES_L2 ((FREE_FRAMES_L1 + 63) / 64)
+
+extern uint64_t free_frames_l0[FREE_FRAMES_L0];
+extern uint64_t free_frames_l1[FREE_FRAMES_L1];
+extern uint64_t free_frames_l2[FREE_FRAMES_L2];
+
+/**
+ * Marks frame <pfn> as free.
+ */
+static inline void free_frames_release(pfn_t pfn) {
+    size_t w = pfn / 64;
+    free_frames_l0[w] |= 1ULL << (pfn % 64);
+    free_frames_l1[w / 64] |= 1ULL << (w % 64);
+    free_frames_l2[w / 4096] |= 1ULL << ((w / 64) % 64);
+}
+
+/**
+ * Marks frame <pfn> as in use.
+ */
+static inline void free_frames_take(pfn_t pfn) {
+    size_t w = pfn / 64;
+    free_frames_l0[w] &= ~(1ULL << (pfn % 64));
+    if (free_frames_l0[w] == 0) {
+        free_frames_l1[w / 64] &= ~(1ULL << (w % 64));
+        if (free_frames_l1[w / 64] == 0) {
+            free_frames_l2[w / 4096] &= ~(1ULL << ((w / 64) % 64));
+        }
+    }
+}
+
+/**
+ * Finds the lowest-numbered free frame.
+ *
+ * @return the frame, or NUM_FRAMES if every frame is in use
+ */
+static inline pfn_t free_frames_first(void) {
+    for (size_t i = 0; i < FREE_FRAMES_L2; i++) {
+        if (free_frames_l2[i]) {
+            size_t w1 = i * 64 + (size_t) __builtin_ctzll(free_frames_l2[i]);
+            size_t w0 = w1 * 64 + (size_t) __builtin_ctzll(free_frames_l1[w1]);
+            return (pfn_t) (w0 * 64 + (size_t) __builtin_ctzll(free_frames_l0[w0]));
+        }
+    }
+    return NUM_FRAMES;
+}
+
+/**
+ * Marks every frame but frame 0, which holds the frame table, as free.
+ */
+void free_frames_init(void);
@@ -4,9 +4,23 @@
 #include "swapops.h"
 #include "stats.h"
 #include "util.h"
+#include "free_frames.h"
 
 pfn_t select_victim_frame(void);
 
+/* The clock hand. It stays where the last sweep stopped, so every sweep
+   resumes after the frame that was last handed out. */
+static pfn_t clock_hand = 0;
+
+
+/*  Find the page table entry mapped to a frame. The frame table keeps the
+    owning process, and the entry lives in that process's page table, which
+    is not necessarily the one PTBR points at right now. */
+static pte_t* frame_pte(pfn_t pfn) {
+    pte_t* table = (pte_t*) (mem + PAGE_SIZE * frame_table[pfn].process->saved_ptbr);
+    return table + frame_table[pfn].vpn;
+}
+
 
 /*  --------------------------------- PROBLEM 7 --------------------------------------
     Make a free frame for the system to use.
@@ -38,8 +52,7 @@ pfn_t free_frame(void) {
 
     /* If the victim is in use, we must evict it first */
     if (frame_table[victim_pfn].mapped) {
-        pte_t* entry = (pte_t*) (mem + PAGE_SIZE * PTBR);   // Calc base of the process frame
-        entry += frame_table[victim_pfn].vpn;               // Readjust base on VPN
+        pte_t* entry = frame_pte(victim_pfn);   // Entry in the owner's page table, not the running process's
         if (entry->dirty) { // check if data was recently changed
             swap_write(entry, (void*) (mem + PAGE_SIZE * victim_pfn));  // Preform a writeback if the dirty bit is high
             stats.writebacks++; // increment
@@ -54,20 +67,75 @@ pfn_t free_frame(void) {
 }
 
 
+/*  Advance the clock hand by one frame, wrapping around the frame table. */
+static inline void clock_advance(void) {
+    clock_hand = (pfn_t) ((clock_hand + 1) % NUM_FRAMES);
+}
 
-pfn_t select_victim_frame() {
-    /* See if there are any free frames first */
-    size_t num_entries = MEM_SIZE / PAGE_SIZE;
-    for (size_t i = 0; i < num_entries; i++) {
-        if (!frame_table[i].protected && !frame_table[i].mapped) {
-            return i;
+
+/*  Second-chance clock. A referenced frame has its bit cleared and is passed
+    over; the first unreferenced frame is the victim. After one full turn every
+    bit is clear, so two turns always find a victim. */
+static pfn_t clock_sweep(void) {
+    for (size_t steps = 0; steps < 2 * NUM_FRAMES; steps++) {
+        pfn_t pfn = clock_hand;
+        clock_advance();
+        if (frame_table[pfn].protected) {
+            continue;
+        }
+        if (!frame_table[pfn].referenced) {
+            return pfn;
+        }
+        frame_table[pfn].referenced = 0;
+    }
+    return NUM_FRAMES;
+}
+
+
+/*  Enhanced clock. Frames are ranked by (referenced, dirty) and the first
+    frame of the lowest class after the hand is the victim, so a clean page is
+    evicted before a dirty one that would cost a writeback:
+       1) look for (0, 0) without changing anything
+       2) look for (0, 1), clearing the referenced bit of every frame passed
+    and repeat once, after which every bit is clear. */
+static pfn_t enhanced_clock_sweep(void) {
+    for (int round = 0; round < 2; round++) {
+        for (size_t steps = 0; steps < NUM_FRAMES; steps++) {
+            pfn_t pfn = clock_hand;
+            clock_advance();
+            if (!frame_table[pfn].protected && !frame_table[pfn].referenced && !frame_pte(pfn)->dirty) {
+                return pfn;
+            }
+        }
+        for (size_t steps = 0; steps < NUM_FRAMES; steps++) {
+            pfn_t pfn = clock_hand;
+            clock_advance();
+            if (frame_table[pfn].protected) {
+                continue;
+            }
+            if (!frame_table[pfn].referenced) {
+                return pfn;
+            }
+            frame_table[pfn].referenced = 0;
         }
     }
+    return NUM_FRAMES;
+}
+
+
+pfn_t select_victim_frame() {
+    /* See if there are any free frames first. The bitmap gives the lowest
+       one without scanning the frame table. */
+    pfn_t free_pfn = free_frames_first();
+    if (free_pfn < NUM_FRAMES) {
+        free_frames_take(free_pfn);
+        return free_pfn;
+    }
 
     if (replacement == RANDOM) {
         /* Play Russian Roulette to decide which frame to evict */
         pfn_t last_unprotected = NUM_FRAMES;
-        for (pfn_t i = 0; i < num_entries; i++) {
+        for (pfn_t i = 0; i < NUM_FRAMES; i++) {
             if (!frame_table[i].protected) {
                 last_unprotected = i;
                 if (prng_rand() % 2) {
@@ -80,7 +148,13 @@ pfn_t select_victim_frame() {
         if (last_unprotected < NUM_FRAMES) {
             return last_unprotected;
         }
-    } 
+    } else if (replacement == CLOCKSWEEP || replacement == ENHANCED_CLOCK) {
+        /* Sweep from wherever the hand stopped last time */
+        pfn_t victim = (replacement == CLOCKSWEEP) ? clock_sweep() : enhanced_clock_sweep();
+        if (victim < NUM_FRAMES) {
+            return victim;
+        }
+    }
 
     /* If every frame is protected, give up. This should never happen
        on the traces we provide you. */
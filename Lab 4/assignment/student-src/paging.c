@@ -2,10 +2,25 @@
 #include "page_splitting.h"
 #include "swapops.h"
 #include "stats.h"
+#include "free_frames.h"
 
  /* The frame table pointer. You will set this up in system_init. */
 fte_t *frame_table;
 
+/* The free-frame bitmap, see free_frames.h */
+uint64_t free_frames_l0[FREE_FRAMES_L0];
+uint64_t free_frames_l1[FREE_FRAMES_L1];
+uint64_t free_frames_l2[FREE_FRAMES_L2];
+
+void free_frames_init(void) {
+    memset(free_frames_l0, 0, sizeof(free_frames_l0));
+    memset(free_frames_l1, 0, sizeof(free_frames_l1));
+    memset(free_frames_l2, 0, sizeof(free_frames_l2));
+    for (pfn_t i = 1; i < NUM_FRAMES; i++) {
+        free_frames_release(i);
+    }
+}
+
 /*  --------------------------------- PROBLEM 2 --------------------------------------
     In this problem, you will initialize the frame table.
 
@@ -58,6 +73,7 @@ void system_init(void) {
      * We mark these special pages as "protected" to indicate this.
      */
     frame_table[0].protected = 1; // Protect the first frame in order to prevent eviction
+    free_frames_init();           // Every other frame starts out free
 }
 
 /*  --------------------------------- PROBLEM 3 --------------------------------------
@@ -201,11 +217,13 @@ void proc_cleanup(pcb_t *proc) {
     for (size_t i = 0; i < NUM_PAGES; i++) {
         if (proc_entry[i].valid) {
             frame_table[proc_entry[i].pfn].mapped = 0;
+            free_frames_release(proc_entry[i].pfn);    // The frame can be handed out again
         }
         if (swap_exists(&proc_entry[i])) swap_free(&proc_entry[i]);
 
     }
 
     /* Free the page table itself in the frame table */
-
+    frame_table[proc->saved_ptbr].protected = 0;
+    free_frames_release(proc->saved_ptbr);
 }